@@ -0,0 +1,114 @@
+#include "radix_sort.h"
+#include "sort_timing.h"
+#include "data_generator.h"
+
+#include <omp.h>
+#include <climits>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// the sizes timed are MIN_SIZE, 4 * MIN_SIZE, ... up to the maximum size; each band reaches halfway to the next
+constexpr int MIN_SIZE = 16;
+constexpr int SIZE_STEP = 4;
+constexpr int DEFAULT_MAX_SIZE = 1 << 24;
+
+constexpr int MAX_INSERTION_SIZE = 256;
+// parallel configurations are only tried when each thread gets at least this many keys
+constexpr int MIN_KEYS_PER_THREAD = 1024;
+
+std::string describeChoice(const RadixSortChoice &choice) {
+    std::string description = algorithmToString(choice.algorithm);
+    if (choice.algorithm == RadixSortAlgorithm::PARALLEL_RADIX_SORT) {
+        description += " " + std::to_string(choice.numThreads) + " threads, " + std::to_string(choice.digitBits)
+                + " bits, buffer " + std::to_string(choice.writeBufferSize);
+    }
+    return description;
+}
+
+// insertion sort, the serial radix sort and every instantiated parallel sort on powers of two threads up to
+// maxThreads (and maxThreads itself)
+std::vector<RadixSortChoice> candidatesFor(const int n, const int maxThreads) {
+    std::vector<RadixSortChoice> candidates;
+    if (n <= MAX_INSERTION_SIZE) {
+        candidates.push_back({RadixSortAlgorithm::INSERTION_SORT, 1});
+    }
+    candidates.push_back({RadixSortAlgorithm::SERIAL_RADIX_SORT, 1});
+
+    std::vector<int> threadCounts;
+    for (int threads = 2; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    if (maxThreads > 1) {
+        threadCounts.push_back(maxThreads);
+    }
+
+    for (const int threads: threadCounts) {
+        if (n / threads < MIN_KEYS_PER_THREAD) {
+            continue;
+        }
+        for (const int digitBits: PARALLEL_DIGIT_BITS) {
+            for (const int writeBufferSize: PARALLEL_WRITE_BUFFER_SIZES) {
+                candidates.push_back({RadixSortAlgorithm::PARALLEL_RADIX_SORT, threads, digitBits, writeBufferSize});
+            }
+        }
+    }
+    return candidates;
+}
+
+bool operator==(const RadixSortChoice &a, const RadixSortChoice &b) {
+    return a.algorithm == b.algorithm && a.numThreads == b.numThreads && a.digitBits == b.digitBits
+           && a.writeBufferSize == b.writeBufferSize;
+}
+
+// usage: autotune [profile path] [max threads] [max size]
+// times every candidate configuration of radix_sort on uniform keys at each size and writes the fastest per size band
+// as the host's tuning profile
+int main(const int argc, char **argv) {
+    const std::string path = argc > 1 ? argv[1] : DEFAULT_PROFILE_PATH;
+    const int maxThreads = argc > 2 ? std::stoi(argv[2]) : omp_get_max_threads();
+    const int maxSize = argc > 3 ? std::stoi(argv[3]) : DEFAULT_MAX_SIZE;
+
+    std::cout << "Tuning radix_sort for up to " << maxThreads << " threads and " << maxSize << " keys...\n";
+    const int *data = DataGenerator::generate(maxSize, DistributionType::UNIFORM);
+
+    RadixSortProfile bands;
+    for (long long size = MIN_SIZE; size <= maxSize; size *= SIZE_STEP) {
+        const int n = static_cast<int>(size);
+
+        RadixSortChoice best{};
+        double bestTime = 0.0;
+        for (const RadixSortChoice &candidate: candidatesFor(n, maxThreads)) {
+            // a single band forces radix_sort onto the candidate
+            setRadixSortProfile({{INT_MAX, candidate}});
+            const double time = timeSort([&](int *keys, const int keysSize) {
+                radix_sort(keys, keysSize, candidate.numThreads);
+            }, data, n);
+
+            if (bestTime == 0.0 || time < bestTime) {
+                best = candidate;
+                bestTime = time;
+            }
+        }
+
+        std::cout << std::scientific << std::setprecision(3) << "  " << n << " keys: " << describeChoice(best)
+                << " (" << bestTime << " s)\n";
+
+        // neighbouring sizes with the same winner share one band
+        const int maxBandSize = static_cast<int>(std::min<long long>(size * 2, INT_MAX));
+        if (!bands.empty() && bands.back().choice == best) {
+            bands.back().maxSize = maxBandSize;
+        } else {
+            bands.push_back({maxBandSize, best});
+        }
+    }
+    delete[] data;
+
+    if (!saveRadixSortProfile(path, bands)) {
+        std::cout << "Could not write the profile to " << path << "\n";
+        return 1;
+    }
+    std::cout << "Profile written to " << path << "\n";
+    return 0;
+}
@@ -1,14 +1,27 @@
 #include "serial_radix_sort.h"
 #include "parallel_radix_sort.h"
+#include "radix_sorter.h"
+#include "radix_sort.h"
+#include "sort_timing.h"
+#include "work_stealing_pool.h"
 #include "data_generator.h"
+#include "huge_page_array.h"
+#include "perf_counters.h"
 
+#include <omp.h>
+#include <sys/resource.h>
 #include <functional>
 #include <cstring>
 #include <chrono>
 #include <algorithm>
+#include <climits>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <ranges>
+#include <sstream>
+#include <string>
+#include <vector>
 
 constexpr int THREAD_COUNTS[] = {1, 2, 4, 8, 16, 32, 64};
 constexpr int INPUT_SIZES[] = {
@@ -19,13 +32,54 @@ constexpr DistributionType DISTRIBUTIONS[] = {
     DistributionType::UNIFORM,
     DistributionType::NORMAL,
     DistributionType::SKEW_SMALL,
-    DistributionType::SKEW_LARGE
+    DistributionType::SKEW_LARGE,
+    DistributionType::SORTED_RUNS,
+    DistributionType::LOW_CARDINALITY
 };
 
 constexpr int NUM_RUNS = 7;
 
+// input sizes of the streaming-store bandwidth runs, from well past any last-level cache upwards
+constexpr int STREAM_BANDWIDTH_SIZES[] = {1 << 27, 1 << 28};
+
+// scatter prefetch distances (in keys, 0 for none) swept on the wide-digit sorters, whose scattered destinations
+// defeat the hardware prefetchers
+constexpr int PREFETCH_DISTANCES[] = {0, 16, 64, 256};
+using Radix11Sorter = RadixSorter<int, 11, 64, RadixFeatures::KeyRangeEarlyExit, RadixFeatures::SkipTrivialPasses>;
+using Radix16Sorter = RadixSorter<int, 16, 0, RadixFeatures::KeyRangeEarlyExit, RadixFeatures::SkipTrivialPasses>;
+
+// input size of the TLB report, 512 MB per array so that 4 KB pages outgrow the reach of any TLB
+constexpr int TLB_REPORT_SIZE = 1 << 27;
+constexpr int TLB_REPORT_RUNS = 3;
+
+// number of keys picked by the radix_topk runs
+constexpr int TOP_K = 1000;
+
+// segment length of the segmented sort runs, e.g. the per-group lists of a group-by
+constexpr int SEGMENT_SIZE = 4096;
+
 const std::string OUTPUT_FILENAME = "../cpu_benchmark_results.csv";
-const std::string OUTPUT_COLUMNS = "Sorter,Input Distribution,Input Size,Thread Count,Average Execution Time [s]";
+const std::string OUTPUT_COLUMNS =
+        "Sorter,Input Distribution,Input Size,Thread Count,Average Execution Time [s],Passes Skipped,Digit Plan";
+
+// the digit widths of the last radix sort, lowest first (e.g. "10+10"), empty for the non-radix sorters
+std::string describePlan(const RadixSortStats &stats) {
+    std::string plan;
+    for (int pass = 0; pass < stats.numPlannedPasses; ++pass) {
+        plan += (pass > 0 ? "+" : "") + std::to_string(stats.passWidths[pass]);
+    }
+    return plan;
+}
+
+// busy/idle seconds and steals of each worker in the last work-stealing sort, e.g. "0.21/0.01 (3 steals) ..."
+std::string describeLoads(const std::vector<WorkerLoad> &loads) {
+    std::ostringstream description;
+    description << std::fixed << std::setprecision(3);
+    for (const WorkerLoad &load: loads) {
+        description << load.busySeconds << "/" << load.idleSeconds << " (" << load.steals << " steals) ";
+    }
+    return description.str();
+}
 
 void runBenchmark(
     const std::string &sorterName,
@@ -37,20 +91,20 @@ void runBenchmark(
     const int inputSize) {
     std::vector<long double> times(NUM_RUNS);
 
+    // on huge pages and faulted in by the sort's threads before the first run, so no run times the kernel zeroing
+    // pages or walks 4 KB page tables on every scattered write
+    const auto inputArray = makeHugePageArray<int>(inputSize, numThreads);
+    const auto outputArray = makeHugePageArray<int>(inputSize, numThreads);
+
     for (int i = 0; i < NUM_RUNS; ++i) {
-        const auto inputArray = new int[inputSize];
-        const auto outputArray = new int[inputSize];
-        std::memcpy(inputArray, originalData, sizeof(int) * inputSize);
+        std::memcpy(inputArray.get(), originalData, sizeof(int) * inputSize);
 
+        lastRadixSortStats = {};
         const auto start = std::chrono::high_resolution_clock::now();
-        sorter(inputArray, outputArray, inputSize, numThreads);
+        sorter(inputArray.get(), outputArray.get(), inputSize, numThreads);
         const auto end = std::chrono::high_resolution_clock::now();
 
         times[i] = std::chrono::duration<long double>(end - start).count();
-
-
-        delete[] inputArray;
-        delete[] outputArray;
     }
 
     std::ranges::sort(times);
@@ -65,10 +119,170 @@ void runBenchmark(
             << DataGenerator::distToString(distribution) << ","
             << inputSize << ","
             << numThreads << ","
-            << average << "\n";
+            << average << ","
+            << lastRadixSortStats.passesSkipped << ","
+            << describePlan(lastRadixSortStats) << "\n";
 }
 
-int main() {
+// times each of radix_sort's algorithms around their crossovers on uniform keys and prints the thresholds for this
+// host and thread count
+int calibrateDispatch(const int numThreads) {
+    constexpr int MAX_INSERTION_SIZE = 512;
+    constexpr int MAX_PARALLEL_SIZE = 1 << 22;
+
+    const int *data = DataGenerator::generate(MAX_PARALLEL_SIZE, DistributionType::UNIFORM);
+    const RadixSortThresholds defaults = radixSortThresholds();
+    const RadixSortProfile loadedProfile = radixSortProfile();
+    setRadixSortProfile({});
+
+    // forces radix_sort onto one algorithm through its thresholds
+    const auto timeAlgorithm = [&](const RadixSortThresholds &forced, const int n) {
+        setRadixSortThresholds(forced);
+        return timeSort([&](int *keys, const int size) { radix_sort(keys, size, numThreads); }, data, n);
+    };
+    const RadixSortThresholds insertionOnly{INT_MAX, INT_MAX};
+    const RadixSortThresholds serialOnly{0, INT_MAX};
+    const RadixSortThresholds parallelOnly{0, 1};
+
+    RadixSortThresholds calibrated = defaults;
+
+    std::cout << std::scientific << std::setprecision(3) << "size,insertion [s],serial radix [s]\n";
+    calibrated.insertionSortMaxSize = 1;
+    for (int n = 2; n <= MAX_INSERTION_SIZE; n *= 2) {
+        const double insertion = timeAlgorithm(insertionOnly, n);
+        const double serial = timeAlgorithm(serialOnly, n);
+        std::cout << n << "," << insertion << "," << serial << "\n";
+        if (insertion <= serial && calibrated.insertionSortMaxSize == n / 2) {
+            calibrated.insertionSortMaxSize = n;
+        }
+    }
+
+    std::cout << "size,serial radix [s],parallel radix on " << numThreads << " threads [s]\n";
+    calibrated.parallelMinKeysPerThread = MAX_PARALLEL_SIZE;
+    for (int n = 1 << 12; n <= MAX_PARALLEL_SIZE && numThreads > 1; n *= 2) {
+        const double serial = timeAlgorithm(serialOnly, n);
+        const double parallel = timeAlgorithm(parallelOnly, n);
+        std::cout << n << "," << serial << "," << parallel << "\n";
+        if (parallel < serial && calibrated.parallelMinKeysPerThread == MAX_PARALLEL_SIZE) {
+            calibrated.parallelMinKeysPerThread = n / numThreads;
+        }
+    }
+
+    setRadixSortThresholds(defaults);
+    setRadixSortProfile(loadedProfile);
+    delete[] data;
+
+    std::cout << "insertionSortMaxSize=" << calibrated.insertionSortMaxSize
+            << " parallelMinKeysPerThread=" << calibrated.parallelMinKeysPerThread << "\n";
+    return 0;
+}
+
+// scatter bandwidth (keys read and written per second by the scattered passes) of ParallelAllOpts, the same sorter
+// with a 16-key write-combining area flushed by memcpy, and ParallelAllOptsStreaming, on uniform keys
+int measureStreamBandwidth(const int numThreads) {
+    using SmallStaging = RadixSorter<int, 8, 16, RadixFeatures::KeyRangeEarlyExit, RadixFeatures::SkipTrivialPasses>;
+    constexpr int MAX_SIZE = STREAM_BANDWIDTH_SIZES[std::size(STREAM_BANDWIDTH_SIZES) - 1];
+    const int *data = DataGenerator::generate(MAX_SIZE, DistributionType::UNIFORM);
+    std::vector<int> output(MAX_SIZE);
+
+    std::cout << std::fixed << std::setprecision(3) << "size,sorter,time [s],scatter bandwidth [GB/s],streamed\n";
+    for (const int n: STREAM_BANDWIDTH_SIZES) {
+        const auto measure = [&](const std::string &name, const std::function<void(int *, int *, int, int)> &sorter) {
+            const double seconds = timeSort([&](int *keys, const int size) {
+                sorter(keys, output.data(), size, numThreads);
+            }, data, n);
+            const RadixSortStats stats = lastRadixSortStats;
+            const double scatteredBytes = 2.0 * stats.passesScattered * n * sizeof(int);
+            std::cout << n << "," << name << "," << seconds << "," << scatteredBytes / seconds / 1e9 << ","
+                    << (stats.streamedStores ? "yes" : "no") << "\n";
+        };
+        measure("ParallelAllOpts", ParallelAllOpts::sort);
+        measure("16-key staging", SmallStaging::sort);
+        measure("ParallelAllOptsStreaming", ParallelAllOptsStreaming::sort);
+    }
+
+    delete[] data;
+    return 0;
+}
+
+long pageFaults() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt + usage.ru_majflt;
+}
+
+// the process's anonymous memory on transparent huge pages in MB, -1 where /proc does not report it
+long anonHugePagesMb() {
+    std::ifstream rollup("/proc/self/smaps_rollup");
+    std::string field;
+    long kilobytes;
+    while (rollup >> field) {
+        if (field == "AnonHugePages:" && rollup >> kilobytes) {
+            return kilobytes / 1024;
+        }
+    }
+    return -1;
+}
+
+std::string countOrNa(const long long count) {
+    return count < 0 ? "n/a" : std::to_string(count);
+}
+
+// time, page faults and dTLB misses of ParallelAllOpts on uniform keys, with its input and output from new[] (the
+// output faulted in 4 KB at a time by the sort's scatter, as in a one-off call) and from prefaulted huge-page arrays
+int reportTlbMisses(const int numThreads) {
+    const int *data = DataGenerator::generate(TLB_REPORT_SIZE, DistributionType::UNIFORM);
+
+    const auto measure = [&](const std::string &arrays, const char *backing, int *input, int *output) {
+        std::memcpy(input, data, sizeof(int) * TLB_REPORT_SIZE);
+
+        double seconds = 0;
+        const long faultsBefore = pageFaults();
+        const TlbMisses misses = countTeamTlbMisses(numThreads, [&] {
+            const auto start = std::chrono::high_resolution_clock::now();
+            ParallelAllOpts::sort(input, output, TLB_REPORT_SIZE, numThreads);
+            const auto end = std::chrono::high_resolution_clock::now();
+            seconds = std::chrono::duration<double>(end - start).count();
+        });
+        const long faults = pageFaults() - faultsBefore;
+
+        std::cout << arrays << "," << backing << "," << seconds << "," << faults << "," << anonHugePagesMb() << ","
+                << countOrNa(misses.loads) << "," << countOrNa(misses.stores) << "\n";
+    };
+
+    std::cout << std::fixed << std::setprecision(3)
+            << "arrays,backing,time [s],page faults,huge pages [MB],dTLB load misses,dTLB store misses\n";
+    for (int run = 0; run < TLB_REPORT_RUNS; ++run) {
+        {
+            const auto input = std::make_unique_for_overwrite<int[]>(TLB_REPORT_SIZE);
+            const auto output = std::make_unique_for_overwrite<int[]>(TLB_REPORT_SIZE);
+            measure("new[]", "small pages", input.get(), output.get());
+        }
+        {
+            const auto input = makeHugePageArray<int>(TLB_REPORT_SIZE, numThreads);
+            const auto output = makeHugePageArray<int>(TLB_REPORT_SIZE, numThreads);
+            measure("makeHugePageArray", pageBackingToString(input.get_deleter().backing), input.get(), output.get());
+        }
+    }
+
+    delete[] data;
+    return 0;
+}
+
+int main(const int argc, char **argv) {
+    if (argc > 1 && std::string(argv[1]) == "--calibrate-dispatch") {
+        const int numThreads = argc > 2 ? std::stoi(argv[2]) : omp_get_max_threads();
+        return calibrateDispatch(numThreads);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--stream-bandwidth") {
+        const int numThreads = argc > 2 ? std::stoi(argv[2]) : omp_get_max_threads();
+        return measureStreamBandwidth(numThreads);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--tlb-report") {
+        const int numThreads = argc > 2 ? std::stoi(argv[2]) : omp_get_max_threads();
+        return reportTlbMisses(numThreads);
+    }
+
     std::ofstream outputFile(OUTPUT_FILENAME);
     outputFile << OUTPUT_COLUMNS << "\n";
 
@@ -83,6 +297,12 @@ int main() {
     for (const auto inputSize: INPUT_SIZES) {
         std::cout << "Input size: " << inputSize << "\n";
 
+        std::vector<int> segmentOffsets;
+        for (int offset = 0; offset < inputSize; offset += SEGMENT_SIZE) {
+            segmentOffsets.push_back(offset);
+        }
+        segmentOffsets.push_back(inputSize);
+
         for (const auto distribution: DISTRIBUTIONS) {
             std::cout << "  Distribution: " << DataGenerator::distToString(distribution) << "\n";
             const int *originalData = preGeneratedData[distribution];
@@ -127,6 +347,88 @@ int main() {
                 runBenchmark("ParallelAllOpts", [&](int *input, int *output, const int size, const int t) {
                     ParallelAllOpts::sort(input, output, size, t);
                 }, outputFile, originalData, distribution, numThreads, inputSize);
+
+                std::cout << "      Running ParallelAllOptsContext with " << numThreads << " threads...\n";
+                ParallelAllOpts::Context context(inputSize, numThreads);
+                runBenchmark("ParallelAllOptsContext", [&](int *input, int *, const int size, int) {
+                    ParallelAllOpts::sortWithContext(context, input, size);
+                }, outputFile, originalData, distribution, numThreads, inputSize);
+
+                std::cout << "      Running ParallelAllOptsFused with " << numThreads << " threads...\n";
+                runBenchmark("ParallelAllOptsFused", [&](int *input, int *output, const int size, const int t) {
+                    ParallelAllOptsFused::sort(input, output, size, t);
+                }, outputFile, originalData, distribution, numThreads, inputSize);
+
+                std::cout << "      Running ParallelAllOptsNextPass with " << numThreads << " threads...\n";
+                runBenchmark("ParallelAllOptsNextPass", [&](int *input, int *output, const int size, const int t) {
+                    ParallelAllOptsNextPass::sort(input, output, size, t);
+                }, outputFile, originalData, distribution, numThreads, inputSize);
+
+                std::cout << "      Running ParallelAllOptsStreaming with " << numThreads << " threads...\n";
+                runBenchmark("ParallelAllOptsStreaming", [&](int *input, int *output, const int size, const int t) {
+                    ParallelAllOptsStreaming::sort(input, output, size, t);
+                }, outputFile, originalData, distribution, numThreads, inputSize);
+
+                for (const int distance: PREFETCH_DISTANCES) {
+                    std::cout << "      Running Radix11/Radix16 with prefetch distance " << distance << " and "
+                            << numThreads << " threads...\n";
+                    RadixSortContext<Radix11Sorter> context11(inputSize, numThreads);
+                    context11.setPrefetchDistance(distance);
+                    runBenchmark("Radix11Prefetch" + std::to_string(distance),
+                                 [&](int *input, int *, const int size, int) { context11.sort(input, size); },
+                                 outputFile, originalData, distribution, numThreads, inputSize);
+
+                    RadixSortContext<Radix16Sorter> context16(inputSize, numThreads);
+                    context16.setPrefetchDistance(distance);
+                    runBenchmark("Radix16Prefetch" + std::to_string(distance),
+                                 [&](int *input, int *, const int size, int) { context16.sort(input, size); },
+                                 outputFile, originalData, distribution, numThreads, inputSize);
+                }
+
+                std::cout << "      Running ParallelAllOptsAdaptive with " << numThreads << " threads...\n";
+                runBenchmark("ParallelAllOptsAdaptive", [&](int *input, int *output, const int size, const int t) {
+                    ParallelAllOptsAdaptive::sort(input, output, size, t);
+                }, outputFile, originalData, distribution, numThreads, inputSize);
+                std::cout << "        plan: " << describePlan(lastRadixSortStats) << "\n";
+
+                std::cout << "      Running ParallelHybrid with " << numThreads << " threads...\n";
+                runBenchmark("ParallelHybrid", [&](int *input, int *output, const int size, const int t) {
+                    ParallelHybrid::sort(input, output, size, t);
+                }, outputFile, originalData, distribution, numThreads, inputSize);
+
+                std::cout << "      Running ParallelInPlace with " << numThreads << " threads...\n";
+                runBenchmark("ParallelInPlace", [&](int *input, int *, const int size, const int t) {
+                    ParallelInPlace::sort(input, size, t);
+                }, outputFile, originalData, distribution, numThreads, inputSize);
+                std::cout << "        busy/idle [s] per thread: " << describeLoads(lastWorkerLoads) << "\n";
+
+                std::cout << "      Running radix_sort with " << numThreads << " threads...\n";
+                runBenchmark("radix_sort", [&](int *input, int *, const int size, const int t) {
+                    radix_sort(input, size, t);
+                }, outputFile, originalData, distribution, numThreads, inputSize);
+
+                std::cout << "      Running radix_select (median) with " << numThreads << " threads...\n";
+                runBenchmark("radix_select", [&](const int *input, int *output, const int size, const int t) {
+                    output[0] = radix_select(input, size, size / 2, t);
+                }, outputFile, originalData, distribution, numThreads, inputSize);
+
+                std::cout << "      Running radix_topk (" << TOP_K << ") with " << numThreads << " threads...\n";
+                runBenchmark("radix_topk", [&](const int *input, int *output, const int size, const int t) {
+                    radix_topk(input, size, TOP_K, output, t);
+                }, outputFile, originalData, distribution, numThreads, inputSize);
+
+                std::cout << "      Running ParallelAllOptsPerSegment with " << numThreads << " threads...\n";
+                runBenchmark("ParallelAllOptsPerSegment", [&](int *input, int *output, const int, const int t) {
+                    for (int segment = 0; segment + 1 < static_cast<int>(segmentOffsets.size()); ++segment) {
+                        const int begin = segmentOffsets[segment];
+                        ParallelAllOpts::sort(input + begin, output + begin, segmentOffsets[segment + 1] - begin, t);
+                    }
+                }, outputFile, originalData, distribution, numThreads, inputSize);
+
+                std::cout << "      Running segmented_sort with " << numThreads << " threads...\n";
+                runBenchmark("segmented_sort", [&](int *input, int *, const int, const int t) {
+                    segmented_sort(input, segmentOffsets.data(), static_cast<int>(segmentOffsets.size()) - 1, t);
+                }, outputFile, originalData, distribution, numThreads, inputSize);
             }
         }
     }
@@ -4,6 +4,7 @@
 #include <omp.h>
 #include <random>
 #include <algorithm>
+#include <limits>
 
 constexpr int UNIFORM_MIN = 0;
 constexpr int UNIFORM_MAX = 1'000'000;
@@ -15,6 +16,8 @@ constexpr double GAMMA_SHAPE = 2.0;
 constexpr double GAMMA_SCALE = 100'000;
 constexpr int GAMMA_MAX = 1'000'000;
 
+constexpr int LOW_CARDINALITY_STRIDE = std::numeric_limits<int>::max() / LOW_CARDINALITY_VALUES;
+
 constexpr int BASE_SEED = 42;
 const int MAX_THREADS = static_cast<int>(std::thread::hardware_concurrency());
 
@@ -60,6 +63,29 @@ int *DataGenerator::generate(const int size, const DistributionType distType) {
                     data[i] = std::max(GAMMA_MAX - static_cast<int>(dis(rng)), UNIFORM_MIN);
                 break;
             }
+
+            case DistributionType::SORTED_RUNS: {
+                std::uniform_int_distribution dis(UNIFORM_MIN, UNIFORM_MAX);
+                #pragma omp for
+                for (int i = 0; i < size; ++i)
+                    data[i] = dis(rng);
+
+                #pragma omp for
+                for (int run = 0; run < SORTED_RUNS_COUNT; ++run) {
+                    const long long runBegin = static_cast<long long>(size) * run / SORTED_RUNS_COUNT;
+                    const long long runEnd = static_cast<long long>(size) * (run + 1) / SORTED_RUNS_COUNT;
+                    std::sort(data + runBegin, data + runEnd);
+                }
+                break;
+            }
+
+            case DistributionType::LOW_CARDINALITY: {
+                std::uniform_int_distribution dis(0, LOW_CARDINALITY_VALUES - 1);
+                #pragma omp for
+                for (int i = 0; i < size; ++i)
+                    data[i] = dis(rng) * LOW_CARDINALITY_STRIDE;
+                break;
+            }
         }
     }
 
@@ -72,6 +98,8 @@ std::string DataGenerator::distToString(const DistributionType distribution) {
         case DistributionType::NORMAL: return "Normal";
         case DistributionType::SKEW_SMALL: return "Skew Small";
         case DistributionType::SKEW_LARGE: return "Skew Large";
+        case DistributionType::SORTED_RUNS: return "Sorted Runs";
+        case DistributionType::LOW_CARDINALITY: return "Low Cardinality";
     }
     return "Unknown";
 }
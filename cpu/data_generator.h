@@ -7,9 +7,16 @@ enum class DistributionType {
     UNIFORM,
     NORMAL,
     SKEW_SMALL,
-    SKEW_LARGE
+    SKEW_LARGE,
+    // uniform keys in SORTED_RUNS_COUNT ascending runs, like a log appended to from two sources
+    SORTED_RUNS,
+    // LOW_CARDINALITY_VALUES distinct keys spread over the whole non-negative range, like enum or status codes
+    LOW_CARDINALITY
 };
 
+constexpr int SORTED_RUNS_COUNT = 2;
+constexpr int LOW_CARDINALITY_VALUES = 256;
+
 class DataGenerator {
 public:
     static int *generate(int size, DistributionType distType);
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <omp.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// what the memory of a HugePageArray came from
+enum class PageBacking {
+    // too small for a huge page: cache-line aligned heap memory
+    HEAP,
+    // the hugetlb pool (MAP_HUGETLB), when the administrator reserved pages for it
+    HUGETLB,
+    // 2 MB-aligned anonymous memory advised with MADV_HUGEPAGE, which the kernel backs with transparent huge pages
+    // as far as it can
+    TRANSPARENT_HUGE_PAGES,
+    // anonymous memory without huge pages, where madvise is not available
+    SMALL_PAGES
+};
+
+constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+constexpr std::size_t HEAP_ALIGNMENT = 64;
+
+// unmaps (or frees) the whole mapping behind the array, so it carries the mapping's size and kind
+template<typename T>
+struct HugePageDelete {
+    std::size_t mappedBytes = 0;
+    PageBacking backing = PageBacking::HEAP;
+
+    void operator()(T *array) const {
+        if (backing == PageBacking::HEAP) {
+            ::operator delete[](array, std::align_val_t{HEAP_ALIGNMENT});
+        } else {
+            munmap(array, mappedBytes);
+        }
+    }
+};
+
+template<typename T>
+using HugePageArray = std::unique_ptr<T[], HugePageDelete<T>>;
+
+namespace huge_page_detail {
+    inline void *mapAnonymous(const std::size_t bytes, const int extraFlags) {
+        void *mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extraFlags, -1, 0);
+        return mapping == MAP_FAILED ? nullptr : mapping;
+    }
+
+    // bytes of anonymous memory starting on a huge page boundary, so that the kernel can back all of it with huge
+    // pages: maps one huge page more than needed and unmaps the unaligned head and the tail
+    inline void *mapHugeAligned(const std::size_t bytes) {
+        auto *mapping = static_cast<char *>(mapAnonymous(bytes + HUGE_PAGE_SIZE, 0));
+        if (mapping == nullptr) {
+            return nullptr;
+        }
+
+        const std::size_t head = (HUGE_PAGE_SIZE - reinterpret_cast<std::uintptr_t>(mapping) % HUGE_PAGE_SIZE) %
+                                 HUGE_PAGE_SIZE;
+        if (head > 0) {
+            munmap(mapping, head);
+        }
+        munmap(mapping + head + bytes, HUGE_PAGE_SIZE - head);
+        return mapping + head;
+    }
+
+    // writes one byte of every small page, each thread of the team a contiguous share in the static split the sorts
+    // read their input in, so that the page faults happen here and every page is local to the thread that uses it
+    inline void prefault(char *bytes, const std::size_t size, const int numThreads) {
+        const long pageSize = sysconf(_SC_PAGESIZE) > 0 ? sysconf(_SC_PAGESIZE) : 4096;
+        const long numPages = static_cast<long>((size + pageSize - 1) / pageSize);
+
+        #pragma omp parallel for num_threads(numThreads) schedule(static) default(none) shared(bytes, pageSize, numPages)
+        for (long page = 0; page < numPages; ++page) {
+            bytes[page * pageSize] = 0;
+        }
+    }
+}
+
+// count uninitialized elements for the large buffers of a sort. Arrays of at least one huge page are mapped from the
+// hugetlb pool if it has pages, and otherwise as 2 MB-aligned memory advised for transparent huge pages, which cuts
+// the page faults and TLB misses of scattering into them; smaller arrays come from the heap. prefaultThreads > 0 has
+// that many threads touch every page up front (outside whatever is timed next), 0 leaves the pages to be faulted in
+// on first use. Throws std::bad_alloc like new when no memory can be had.
+template<typename T>
+HugePageArray<T> makeHugePageArray(const std::size_t count, const int prefaultThreads) {
+    static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>);
+    const std::size_t bytes = count * sizeof(T);
+
+    if (bytes < HUGE_PAGE_SIZE) {
+        return HugePageArray<T>(static_cast<T *>(::operator new[](bytes, std::align_val_t{HEAP_ALIGNMENT})),
+                                HugePageDelete<T>{bytes, PageBacking::HEAP});
+    }
+
+    const std::size_t mappedBytes = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    PageBacking backing = PageBacking::HUGETLB;
+    void *mapping = nullptr;
+#ifdef MAP_HUGETLB
+    mapping = huge_page_detail::mapAnonymous(mappedBytes, MAP_HUGETLB);
+#endif
+    if (mapping == nullptr) {
+        mapping = huge_page_detail::mapHugeAligned(mappedBytes);
+        if (mapping == nullptr) {
+            throw std::bad_alloc();
+        }
+        backing = PageBacking::SMALL_PAGES;
+#ifdef MADV_HUGEPAGE
+        if (madvise(mapping, mappedBytes, MADV_HUGEPAGE) == 0) {
+            backing = PageBacking::TRANSPARENT_HUGE_PAGES;
+        }
+#endif
+    }
+
+    if (prefaultThreads > 0) {
+        huge_page_detail::prefault(static_cast<char *>(mapping), mappedBytes, prefaultThreads);
+    }
+    return HugePageArray<T>(static_cast<T *>(mapping), HugePageDelete<T>{mappedBytes, backing});
+}
+
+inline const char *pageBackingToString(const PageBacking backing) {
+    switch (backing) {
+        case PageBacking::HEAP: return "heap";
+        case PageBacking::HUGETLB: return "hugetlb";
+        case PageBacking::TRANSPARENT_HUGE_PAGES: return "transparent huge pages";
+        case PageBacking::SMALL_PAGES: return "small pages";
+    }
+    return "unknown";
+}
@@ -0,0 +1,361 @@
+#pragma once
+
+#include "radix_sorter.h"
+#include "work_stealing_pool.h"
+
+#include <omp.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <memory>
+#include <utility>
+
+// in-place MSD radix sort engine (PARADIS-style): each level partitions a range by its top digit, then recurses on
+// the buckets. Large ranges are partitioned by the whole team: every thread moves keys between its own stripes of
+// the buckets, a repair step compacts the keys that found no room to the end of each bucket, and the rounds repeat
+// on what is left. The buckets that one thread can sort are spread over the team by a work-stealing pool, which
+// splits the large ones further so that skewed inputs stay balanced. Besides the keys it needs only per-thread
+// bucket heads and tails, O(numThreads * NUM_BUCKETS), and the pool's deques.
+// - DigitBits: bits partitioned per level (NUM_BUCKETS = 2^DigitBits)
+template<typename Key, int DigitBits = 8>
+class InPlaceRadixSorter {
+    static_assert(DigitBits >= 1 && DigitBits <= 12, "digit width must be between 1 and 12 bits");
+
+public:
+    using Bits = typename RadixKeyTraits<Key>::Bits;
+
+    static constexpr int KEY_BITS = sizeof(Bits) * 8;
+    static constexpr int NUM_BUCKETS = 1 << DigitBits;
+
+    // ranges shorter than this are insertion sorted
+    static constexpr int INSERTION_SORT_SIZE = 32;
+
+    // ranges shorter than this are partitioned by a single thread
+    static constexpr int PARALLEL_PARTITION_SIZE = 1 << 16;
+
+    // partition rounds stop being split across the team once fewer keys than this are left to place
+    static constexpr int SERIAL_ROUND_SIZE = 1 << 12;
+
+    // pool tasks at least this large are partitioned by one level and their buckets spawned as new tasks
+    static constexpr int SPLIT_TASK_SIZE = 1 << 14;
+
+    // records the team's busy and idle time in lastWorkerLoads
+    static void sort(Key *arr, const int n, const int numThreads) {
+        lastWorkerLoads.assign(numThreads, {});
+        if (n <= 1) {
+            return;
+        }
+
+        // every key shares the bits above the highest one that differs between the min and the max
+        const auto [globalMin, globalMax] = parallelMinMax(arr, n, numThreads);
+        const int numBits = std::bit_width(static_cast<Bits>(globalMin ^ globalMax));
+        if (numBits > 0) {
+            sortRange(arr, n, numBits, numThreads);
+        }
+    }
+
+private:
+    // per-thread rows are padded to whole cache lines so neighbouring threads never share one
+    static constexpr int THREAD_STRIDE = (NUM_BUCKETS + 15) & ~15;
+
+    // the digit of the level that sorts the topBits low bits of the keys
+    struct Level {
+        int shift;
+        Bits mask;
+
+        explicit Level(const int topBits)
+            : shift(std::max(0, topBits - DigitBits)), mask((Bits{1} << (topBits - shift)) - 1) {}
+
+        int digitOf(const Key key) const {
+            return static_cast<int>((RadixKeyTraits<Key>::toBits(key) >> shift) & mask);
+        }
+    };
+
+    // a range of keys that differ only in their topBits low bits, packed into one word for the lock-free deques;
+    // ranges too long for the size field are not spawned but split by the thread that finds them
+    struct RangeTask {
+        static constexpr int SIZE_BITS = 27;
+        static constexpr int MAX_SIZE = (1 << SIZE_BITS) - 1;
+
+        uint64_t word;
+
+        RangeTask() = default;
+
+        RangeTask(const int begin, const int size, const int topBits)
+            : word(static_cast<uint64_t>(begin) << (SIZE_BITS + 6) | static_cast<uint64_t>(size) << 6 | topBits) {}
+
+        int begin() const { return static_cast<int>(word >> (SIZE_BITS + 6)); }
+        int size() const { return static_cast<int>((word >> 6) & MAX_SIZE); }
+        int topBits() const { return static_cast<int>(word & 63); }
+    };
+
+    static std::pair<Bits, Bits> parallelMinMax(const Key *arr, const int n, const int numThreads) {
+        Bits globalMin = std::numeric_limits<Bits>::max();
+        Bits globalMax = 0;
+
+        #pragma omp parallel for num_threads(numThreads) schedule(static) default(none) shared(arr, n) reduction(min: globalMin) reduction(max: globalMax)
+        for (int i = 0; i < n; ++i) {
+            const Bits bits = RadixKeyTraits<Key>::toBits(arr[i]);
+            globalMin = std::min(globalMin, bits);
+            globalMax = std::max(globalMax, bits);
+        }
+
+        return {globalMin, globalMax};
+    }
+
+    // sorts a range whose keys differ only in their topBits low bits
+    static void sortRange(Key *arr, const int n, const int topBits, const int numThreads) {
+        if (numThreads == 1 || n < PARALLEL_PARTITION_SIZE) {
+            serialSort(arr, n, topBits);
+            return;
+        }
+
+        const Level level(topBits);
+        std::array<int, NUM_BUCKETS + 1> bucketBegin;
+        parallelPartition(arr, n, level, numThreads, bucketBegin.data());
+        if (level.shift == 0) {
+            return;
+        }
+
+        // buckets too large for one thread get the whole team one at a time, the rest go to the work-stealing pool
+        const int largeBucketSize = std::max(PARALLEL_PARTITION_SIZE, n / numThreads);
+        for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+            const int size = bucketBegin[bucket + 1] - bucketBegin[bucket];
+            if (size > largeBucketSize) {
+                sortRange(arr + bucketBegin[bucket], size, level.shift, numThreads);
+            }
+        }
+
+        WorkStealingPool<RangeTask> pool(numThreads);
+        const auto process = [&](const RangeTask task, const int worker) {
+            sortTask(arr, task.begin(), task.size(), task.topBits(), pool, worker);
+        };
+
+        #pragma omp parallel num_threads(numThreads) default(none) shared(arr, bucketBegin, level, largeBucketSize, pool, process)
+        {
+            const int tid = omp_get_thread_num();
+            for (int bucket = tid; bucket < NUM_BUCKETS; bucket += omp_get_num_threads()) {
+                const int size = bucketBegin[bucket + 1] - bucketBegin[bucket];
+                if (size > 1 && size <= largeBucketSize) {
+                    spawnOrSort(arr, bucketBegin[bucket], size, level.shift, pool, tid, process);
+                }
+            }
+
+            #pragma omp barrier
+
+            pool.run(tid, process);
+        }
+
+        pool.addLoadsTo(lastWorkerLoads);
+    }
+
+    template<typename Process>
+    static void spawnOrSort(Key *arr, const int begin, const int size, const int topBits,
+                            WorkStealingPool<RangeTask> &pool, const int worker, Process &process) {
+        if (size <= RangeTask::MAX_SIZE) {
+            pool.spawn(worker, RangeTask(begin, size, topBits), process);
+        } else {
+            sortTask(arr, begin, size, topBits, pool, worker);
+        }
+    }
+
+    // a pool task: small ranges are sorted outright, larger ones are partitioned by their top digit and their
+    // buckets spawned, so that idle threads can steal parts of a skewed bucket
+    static void sortTask(Key *arr, const int begin, const int size, const int topBits,
+                         WorkStealingPool<RangeTask> &pool, const int worker) {
+        if (size < SPLIT_TASK_SIZE) {
+            serialSort(arr + begin, size, topBits);
+            return;
+        }
+
+        const Level level(topBits);
+        std::array<int, NUM_BUCKETS + 1> bucketBegin;
+        serialPartition(arr + begin, size, level, bucketBegin.data());
+        if (level.shift == 0) {
+            return;
+        }
+
+        const auto process = [&arr, &pool](const RangeTask task, const int taskWorker) {
+            sortTask(arr, task.begin(), task.size(), task.topBits(), pool, taskWorker);
+        };
+        for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+            const int bucketSize = bucketBegin[bucket + 1] - bucketBegin[bucket];
+            if (bucketSize > 1) {
+                spawnOrSort(arr, begin + bucketBegin[bucket], bucketSize, level.shift, pool, worker, process);
+            }
+        }
+    }
+
+    // American flag sort: partition by the top digit and recurse on the buckets
+    static void serialSort(Key *arr, const int n, const int topBits) {
+        if (n < INSERTION_SORT_SIZE) {
+            insertionSort(arr, n);
+            return;
+        }
+
+        const Level level(topBits);
+        std::array<int, NUM_BUCKETS + 1> bucketBegin;
+        serialPartition(arr, n, level, bucketBegin.data());
+
+        if (level.shift == 0) {
+            return;
+        }
+        for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+            serialSort(arr + bucketBegin[bucket], bucketBegin[bucket + 1] - bucketBegin[bucket], level.shift);
+        }
+    }
+
+    // count the digit, then cycle every key into its bucket; writes the bucket boundaries into bucketBegin
+    static void serialPartition(Key *arr, const int n, const Level &level, int *bucketBegin) {
+        std::fill_n(bucketBegin, NUM_BUCKETS + 1, 0);
+        for (int i = 0; i < n; ++i) {
+            bucketBegin[level.digitOf(arr[i]) + 1]++;
+        }
+        for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+            bucketBegin[bucket + 1] += bucketBegin[bucket];
+        }
+
+        std::array<int, NUM_BUCKETS> heads;
+        std::copy_n(bucketBegin, NUM_BUCKETS, heads.begin());
+        for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+            while (heads[bucket] < bucketBegin[bucket + 1]) {
+                Key key = arr[heads[bucket]];
+                for (int digit = level.digitOf(key); digit != bucket; digit = level.digitOf(key)) {
+                    std::swap(key, arr[heads[digit]++]);
+                }
+                arr[heads[bucket]++] = key;
+            }
+        }
+    }
+
+    static void insertionSort(Key *arr, const int n) {
+        for (int i = 1; i < n; ++i) {
+            const Key key = arr[i];
+            const Bits bits = RadixKeyTraits<Key>::toBits(key);
+            int j = i;
+            for (; j > 0 && RadixKeyTraits<Key>::toBits(arr[j - 1]) > bits; --j) {
+                arr[j] = arr[j - 1];
+            }
+            arr[j] = key;
+        }
+    }
+
+    // partitions arr by the level's digit with the whole team and writes the bucket boundaries into bucketBegin.
+    // Each round splits the unplaced part of every bucket, [heads, tails), into one stripe per thread, permutes within
+    // the stripes, then repairs each bucket so that its unplaced keys form a suffix again; a round that places too
+    // little is rerun with a single stripe, which is plain American flag and always finishes.
+    static void parallelPartition(Key *arr, const int n, const Level &level, const int numThreads,
+                                  int *bucketBegin) {
+        const auto localHistograms = std::make_unique<int[]>(numThreads * THREAD_STRIDE);
+        const auto stripeHeads = std::make_unique<int[]>(numThreads * THREAD_STRIDE);
+        const auto stripeTails = std::make_unique<int[]>(numThreads * THREAD_STRIDE);
+        std::array<int, NUM_BUCKETS> heads;
+        std::array<int, NUM_BUCKETS> tails;
+
+        #pragma omp parallel num_threads(numThreads) default(none) shared(arr, n, level, localHistograms)
+        {
+            const int tid = omp_get_thread_num();
+            int *localHistogram = &localHistograms[tid * THREAD_STRIDE];
+            std::fill_n(localHistogram, NUM_BUCKETS, 0);
+
+            #pragma omp for schedule(static)
+            for (int i = 0; i < n; ++i) {
+                localHistogram[level.digitOf(arr[i])]++;
+            }
+        }
+
+        bucketBegin[0] = 0;
+        for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+            int count = 0;
+            for (int t = 0; t < numThreads; ++t) {
+                count += localHistograms[t * THREAD_STRIDE + bucket];
+            }
+            bucketBegin[bucket + 1] = bucketBegin[bucket] + count;
+            heads[bucket] = bucketBegin[bucket];
+            tails[bucket] = bucketBegin[bucket + 1];
+        }
+
+        int unplaced = n;
+        int numStripes = numThreads;
+        while (unplaced > 0) {
+            #pragma omp parallel num_threads(numStripes) default(none) shared(arr, level, stripeHeads, stripeTails, heads, tails)
+            {
+                const int tid = omp_get_thread_num();
+                const int teamSize = omp_get_num_threads();
+                int *threadHeads = &stripeHeads[tid * THREAD_STRIDE];
+                int *threadTails = &stripeTails[tid * THREAD_STRIDE];
+                for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+                    const long long size = tails[bucket] - heads[bucket];
+                    threadHeads[bucket] = heads[bucket] + static_cast<int>(size * tid / teamSize);
+                    threadTails[bucket] = heads[bucket] + static_cast<int>(size * (tid + 1) / teamSize);
+                }
+
+                permuteStripes(arr, level, threadHeads, threadTails);
+
+                #pragma omp barrier
+
+                #pragma omp for schedule(dynamic, 1)
+                for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+                    heads[bucket] = repairBucket(arr, level, bucket, stripeHeads.get(), stripeTails.get(), teamSize,
+                                                 tails[bucket]);
+                }
+            }
+
+            int stillUnplaced = 0;
+            for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+                stillUnplaced += tails[bucket] - heads[bucket];
+            }
+            if (stillUnplaced == unplaced || stillUnplaced < SERIAL_ROUND_SIZE) {
+                numStripes = 1;
+            }
+            unplaced = stillUnplaced;
+        }
+    }
+
+    // cycles keys between one thread's stripes. Every stripe keeps its placed keys in [stripe begin, heads); a key
+    // whose destination stripe is already full stays behind in the stripe being scanned, after the placed ones.
+    static void permuteStripes(Key *arr, const Level &level, int *heads, const int *tails) {
+        for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+            for (int scan = heads[bucket]; scan < tails[bucket]; ++scan) {
+                Key key = arr[scan];
+                int digit = level.digitOf(key);
+                while (digit != bucket && heads[digit] < tails[digit]) {
+                    std::swap(key, arr[heads[digit]++]);
+                    digit = level.digitOf(key);
+                }
+
+                if (digit == bucket) {
+                    // close the cycle behind the placed keys, moving a left-behind key into the hole if there is one
+                    arr[scan] = arr[heads[bucket]];
+                    arr[heads[bucket]++] = key;
+                } else {
+                    arr[scan] = key;
+                }
+            }
+        }
+    }
+
+    // after a round, [begin of bucket, tail) of the bucket holds placed keys except for the unplaced remainders
+    // [stripeHeads, stripeTails) of each thread's stripe; swaps the bucket's own keys out of those remainders with
+    // foreign keys from the back, and returns where the foreign keys, now a suffix of the bucket, begin
+    static int repairBucket(Key *arr, const Level &level, const int bucket, const int *stripeHeads,
+                            const int *stripeTails, const int numStripes, int tail) {
+        for (int t = 0; t < numStripes; ++t) {
+            const int stripeEnd = stripeTails[t * THREAD_STRIDE + bucket];
+            for (int i = stripeHeads[t * THREAD_STRIDE + bucket]; i < stripeEnd && i < tail; ++i) {
+                if (level.digitOf(arr[i]) == bucket) {
+                    continue;
+                }
+                while (tail > i + 1 && level.digitOf(arr[tail - 1]) != bucket) {
+                    --tail;
+                }
+                if (tail == i + 1) {
+                    return i;
+                }
+                std::swap(arr[i], arr[--tail]);
+            }
+        }
+        return tail;
+    }
+};
@@ -1,5 +1,9 @@
 #pragma once
 
+#include "radix_sorter.h"
+
+#include <cstdint>
+
 namespace BaseParallel {
     void sort(const int *inputArray, int *outputArray, int n, int numThreads);
 }
@@ -17,9 +21,88 @@ namespace ParallelOptC {
 }
 
 namespace ParallelAllOpts {
+    // sorted, reversed and few-run inputs are finished without radix passes, inputs of few distinct keys are
+    // counting sorted
+    using Sorter = RadixSorter<int, 8, 128, RadixFeatures::KeyRangeEarlyExit, RadixFeatures::SkipTrivialPasses,
+                               RadixFeatures::PresortedRuns, RadixFeatures::LowCardinality>;
+
+    // scratch and ping-pong buffer kept across sorts, for many repeated sorts on the same number of threads
+    using Context = RadixSortContext<Sorter>;
+
     void sort(int *inputArray, int *outputArray, int n, int numThreads);
+
+    // sorts arr in place with the context's threads and scratch, allocating only if n outgrows its capacity
+    void sortWithContext(Context &context, int *arr, int n);
+
+    // stable key-value sort, keys and values are both sorted in place
+    void sortPairs(int *keys, uint32_t *values, int n, int numThreads);
+
+    void sortPairs(int *keys, uint64_t *values, int n, int numThreads);
+
+    // fuses each key and value into one 64-bit word so the scatter moves a single stream
+    void sortPairsPacked(int *keys, uint32_t *values, int n, int numThreads);
+
+    // writes the permutation that stably sorts keys into indices, keys are left untouched
+    void argsort(const int *keys, uint32_t *indices, int n, int numThreads);
 }
 
 namespace ParallelOptAC {
     void sort(int *inputArray, int *outputArray, int n, int numThreads);
 }
+
+// ParallelAllOpts with every digit counted in the first read, later passes are scatter-only; the digits are counted
+// before the min is known, so the early exit is taken on min ^ max instead of the key range
+namespace ParallelAllOptsFused {
+    void sort(int *inputArray, int *outputArray, int n, int numThreads);
+}
+
+// ParallelAllOpts with only the first histogram read from the input, each scatter counts the digit of the next pass
+// (5 instead of 8 reads and writes of the array for 4 passes)
+namespace ParallelAllOptsNextPass {
+    void sort(int *inputArray, int *outputArray, int n, int numThreads);
+}
+
+// ParallelAllOpts with a 16 KB write-combining area per thread (one cache line per bucket) flushed with non-temporal
+// stores once the input outgrows the last-level cache
+namespace ParallelAllOptsStreaming {
+    void sort(int *inputArray, int *outputArray, int n, int numThreads);
+}
+
+// ParallelAllOpts with up to 11 bits per pass: n, the thread count and the host's L1/L2 sizes pick the sorter compiled
+// for the widest digit that fits (8 to 11 bits), which splits the key range evenly over its passes (e.g. 2 x 10 bits
+// instead of 3 x 8 for a 20-bit range)
+namespace ParallelAllOptsAdaptive {
+    void sort(int *inputArray, int *outputArray, int n, int numThreads);
+}
+
+// one parallel MSD pass into L2-sized buckets, then each thread finishes whole buckets with in-cache LSD passes
+namespace ParallelHybrid {
+    void sort(int *inputArray, int *outputArray, int n, int numThreads);
+}
+
+// in-place MSD radix sort, 8 bits per level: no second n-element array, only O(numThreads * 256) scratch
+namespace ParallelInPlace {
+    void sort(int *arr, int n, int numThreads);
+}
+
+// floating-point keys in IEEE totalOrder (-NaN < -inf < ... < -0.0 < +0.0 < ... < +inf < +NaN), both widths with
+// KeyRangeEarlyExit and SkipTrivialPasses; floats take 8-bit digits, doubles 11-bit ones
+namespace ParallelAllOptsFloat {
+    void sort(float *inputArray, float *outputArray, int n, int numThreads);
+
+    void sort(double *inputArray, double *outputArray, int n, int numThreads);
+}
+
+// 64-bit keys: ParallelAllOpts with 11 bits per pass
+namespace ParallelAllOpts64Digit11 {
+    void sort(int64_t *inputArray, int64_t *outputArray, int n, int numThreads);
+
+    void sort(uint64_t *inputArray, uint64_t *outputArray, int n, int numThreads);
+}
+
+// 64-bit keys: as above with 16 bits per pass, at most 4 passes
+namespace ParallelAllOpts64Digit16 {
+    void sort(int64_t *inputArray, int64_t *outputArray, int n, int numThreads);
+
+    void sort(uint64_t *inputArray, uint64_t *outputArray, int n, int numThreads);
+}
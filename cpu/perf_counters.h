@@ -0,0 +1,117 @@
+#pragma once
+
+#include <omp.h>
+#include <array>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// dTLB misses of a measured region, -1 where the kernel or the (virtual) machine does not expose the event
+struct TlbMisses {
+    long long loads = -1;
+    long long stores = -1;
+};
+
+// dTLB load and store miss counters of the calling thread's user-mode code, opened disabled through perf_event_open
+class ThreadTlbCounters {
+public:
+    ThreadTlbCounters() {
+#if defined(__linux__)
+        fds[0] = open(PERF_COUNT_HW_CACHE_OP_READ);
+        fds[1] = open(PERF_COUNT_HW_CACHE_OP_WRITE);
+#endif
+    }
+
+    ~ThreadTlbCounters() {
+#if defined(__linux__)
+        for (const int fd: fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    ThreadTlbCounters(const ThreadTlbCounters &) = delete;
+    ThreadTlbCounters &operator=(const ThreadTlbCounters &) = delete;
+
+    void start() const {
+#if defined(__linux__)
+        for (const int fd: fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    TlbMisses stop() const {
+        std::array<long long, 2> counts = {-1, -1};
+#if defined(__linux__)
+        for (int event = 0; event < 2; ++event) {
+            long long count;
+            if (fds[event] >= 0) {
+                ioctl(fds[event], PERF_EVENT_IOC_DISABLE, 0);
+                if (read(fds[event], &count, sizeof(count)) == sizeof(count)) {
+                    counts[event] = count;
+                }
+            }
+        }
+#endif
+        return {counts[0], counts[1]};
+    }
+
+private:
+    std::array<int, 2> fds = {-1, -1};
+
+#if defined(__linux__)
+    static int open(const unsigned long long op) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | op << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+        attr.disabled = 1;
+        // user mode only, which unprivileged processes may count under the default perf_event_paranoid
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+};
+
+// dTLB misses summed over every thread of run(), which must use teams of numThreads: the counters count one thread
+// each, so they are opened in a parallel region of that size and rely on OpenMP running run's regions on the same
+// pooled threads; -1 if any thread's counter is unavailable
+inline TlbMisses countTeamTlbMisses(const int numThreads, const std::function<void()> &run) {
+    std::vector<std::unique_ptr<ThreadTlbCounters>> counters(numThreads);
+    #pragma omp parallel num_threads(numThreads) default(none) shared(counters)
+    {
+        counters[omp_get_thread_num()] = std::make_unique<ThreadTlbCounters>();
+        counters[omp_get_thread_num()]->start();
+    }
+
+    run();
+
+    std::vector<TlbMisses> perThread(numThreads);
+    #pragma omp parallel num_threads(numThreads) default(none) shared(counters, perThread)
+    {
+        if (counters[omp_get_thread_num()] != nullptr) {
+            perThread[omp_get_thread_num()] = counters[omp_get_thread_num()]->stop();
+        }
+    }
+
+    TlbMisses total{0, 0};
+    for (const TlbMisses &misses: perThread) {
+        total.loads = total.loads < 0 || misses.loads < 0 ? -1 : total.loads + misses.loads;
+        total.stores = total.stores < 0 || misses.stores < 0 ? -1 : total.stores + misses.stores;
+    }
+    return total;
+}
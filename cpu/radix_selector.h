@@ -0,0 +1,208 @@
+#pragma once
+
+#include "radix_sorter.h"
+
+#include <omp.h>
+#include <algorithm>
+#include <utility>
+
+// parallel radix select on the histogram kernels of a RadixSorter: every level counts the top digit of the remaining
+// candidates, keeps only the bucket that holds the wanted rank and compacts it into scratch, counting the next digit
+// of each key it moves, so the input is read about twice (one histogram, one compaction) and later levels touch only
+// the surviving bucket. Levels on which every candidate shares the digit move nothing. The compaction can also
+// collect the keys of the buckets below (or above) the kept one, which gives the k smallest (or largest) keys in the
+// same two reads.
+template<typename Sorter>
+class RadixSelector {
+public:
+    using Key = typename Sorter::KeyType;
+    using Bits = typename Sorter::Bits;
+
+    // the key of rank k (0-based, the k-th smallest) of arr[0, n), which is left untouched; requires 0 <= k < n
+    static Key select(const Key *arr, const int n, const int k, const int numThreads) {
+        return selectRank<false>(arr, n, k, nullptr, numThreads);
+    }
+
+    // the k smallest keys of arr into out, in no particular order
+    static void smallest(const Key *arr, const int n, const int k, Key *out, const int numThreads) {
+        if (k > 0) {
+            out[k - 1] = selectRank<false>(arr, n, k - 1, out, numThreads);
+        }
+    }
+
+    // the k largest keys of arr into out, in no particular order
+    static void largest(const Key *arr, const int n, const int k, Key *out, const int numThreads) {
+        if (k > 0) {
+            out[k - 1] = selectRank<true>(arr, n, n - k, out, numThreads);
+        }
+    }
+
+private:
+    static constexpr int THREAD_STRIDE = Sorter::THREAD_STRIDE;
+    static constexpr int DIGIT_BITS = std::countr_zero(static_cast<unsigned>(Sorter::NUM_BUCKETS));
+
+    // the key of the given rank; when collected is not null, it receives the keys that order strictly below it
+    // (ABOVE: strictly above it), topped up with copies of the selected key to rank (ABOVE: n - 1 - rank) keys
+    template<bool ABOVE>
+    static Key selectRank(const Key *arr, const int n, int rank, Key *collected, const int numThreads) {
+        const int numWanted = ABOVE ? n - 1 - rank : rank;
+
+        // the current level's histograms and the next level's, counted by the compaction; they swap every level
+        const AlignedArray<int> histogramSets[2] = {
+            makeAlignedArray<int>(numThreads * THREAD_STRIDE), makeAlignedArray<int>(numThreads * THREAD_STRIDE)
+        };
+        // per thread: where its candidates begin and end, and where it writes the next candidates and collected keys
+        const auto rangeBegins = makeAlignedArray<int>(numThreads);
+        const auto rangeEnds = makeAlignedArray<int>(numThreads);
+        const auto candidateOffsets = makeAlignedArray<int>(numThreads);
+        const auto collectOffsets = makeAlignedArray<int>(numThreads);
+
+        AlignedArray<Key> scratch[2];
+        const Key *candidates = arr;
+        int numCandidates = n;
+        int numCollected = 0;
+        int bitsLeft = Sorter::KEY_BITS;
+        int keptBucket = 0;
+        int currentSet = 0;
+        bool counted = false;
+        bool trivial = false;
+        int level = 0;
+
+        #pragma omp parallel num_threads(numThreads) proc_bind(close) default(none) shared(n, rank, collected, histogramSets, currentSet, rangeBegins, rangeEnds, candidateOffsets, collectOffsets, scratch, candidates, numCandidates, numCollected, bitsLeft, keptBucket, counted, trivial, level)
+        {
+            const int tid = omp_get_thread_num();
+            const int teamSize = omp_get_num_threads();
+            // each thread keeps reading the candidates it wrote itself, so its counts stay valid for its offsets
+            const auto [begin, end] = Sorter::threadRange(n, tid, teamSize);
+            rangeBegins[tid] = begin;
+            rangeEnds[tid] = end;
+
+            while (numCandidates > 1 && bitsLeft > 0) {
+                const int digitBits = std::min(DIGIT_BITS, bitsLeft);
+                const int shift = bitsLeft - digitBits;
+                const int digitMask = (1 << digitBits) - 1;
+                int *histogram = &histogramSets[currentSet][tid * THREAD_STRIDE];
+                int *nextHistogram = &histogramSets[1 - currentSet][tid * THREAD_STRIDE];
+
+                if (!counted) {
+                    Sorter::computeLocalHistograms(candidates, rangeBegins[tid], rangeEnds[tid], histogram, shift,
+                                                   digitMask, 0);
+                }
+
+                #pragma omp barrier
+
+                #pragma omp single
+                {
+                    keepRankBucket<ABOVE>(histogramSets[currentSet].get(), teamSize, digitMask, rank, numCandidates,
+                                          numCollected, candidateOffsets.get(), collectOffsets.get(), keptBucket,
+                                          trivial);
+                    if (!trivial && !scratch[0]) {
+                        // the first bucket kept is the largest set of candidates there will be
+                        scratch[0] = makeAlignedArray<Key>(numCandidates);
+                        scratch[1] = makeAlignedArray<Key>(numCandidates);
+                    }
+                }
+
+                int candidatesEnd = 0;
+                if (!trivial) {
+                    Key *next = scratch[level % 2].get();
+                    candidatesEnd = compactBucket<ABOVE>(candidates, rangeBegins[tid], rangeEnds[tid], next, collected,
+                                                         shift, digitMask, keptBucket, candidateOffsets[tid],
+                                                         collectOffsets[tid], nextHistogram,
+                                                         std::min(DIGIT_BITS, shift));
+                }
+
+                #pragma omp barrier
+
+                #pragma omp single
+                {
+                    if (!trivial) {
+                        candidates = scratch[level % 2].get();
+                        currentSet = 1 - currentSet;
+                        ++level;
+                    }
+                    counted = !trivial;
+                    bitsLeft = shift;
+                }
+
+                if (counted) {
+                    rangeBegins[tid] = candidateOffsets[tid];
+                    rangeEnds[tid] = candidatesEnd;
+                }
+
+                #pragma omp barrier
+            }
+        }
+
+        // the candidates left are all equal to the selected key
+        const Key selected = candidates[0];
+        if (collected != nullptr) {
+            std::fill(collected + numCollected, collected + numWanted, selected);
+        }
+        return selected;
+    }
+
+    // reduces the threads' histograms, finds the bucket that holds rank, and sets up the compaction: the thread
+    // offsets into the next candidates and into the collected keys, which take the buckets below (ABOVE: above) the
+    // kept one. rank becomes the rank within the kept bucket. A bucket holding every candidate is trivial and stays
+    // where it is.
+    template<bool ABOVE>
+    static void keepRankBucket(const int *histograms, const int numThreads, const int digitMask, int &rank,
+                               int &numCandidates, int &numCollected, int *candidateOffsets, int *collectOffsets,
+                               int &keptBucket, bool &trivial) {
+        int below = 0;
+        keptBucket = 0;
+        for (;; ++keptBucket) {
+            int count = 0;
+            for (int t = 0; t < numThreads; ++t) {
+                count += histograms[t * THREAD_STRIDE + keptBucket];
+            }
+            if (rank < below + count) {
+                break;
+            }
+            below += count;
+        }
+
+        int candidateOffset = 0;
+        int collectOffset = numCollected;
+        for (int t = 0; t < numThreads; ++t) {
+            const int *histogram = &histograms[t * THREAD_STRIDE];
+            candidateOffsets[t] = candidateOffset;
+            collectOffsets[t] = collectOffset;
+            candidateOffset += histogram[keptBucket];
+            for (int bucket = ABOVE ? keptBucket + 1 : 0; bucket < (ABOVE ? digitMask + 1 : keptBucket); ++bucket) {
+                collectOffset += histogram[bucket];
+            }
+        }
+
+        trivial = candidateOffset == numCandidates;
+        rank -= below;
+        numCandidates = candidateOffset;
+        numCollected = collectOffset;
+    }
+
+    // moves the thread's keys of the kept bucket to next and (if collected is not null) those of the buckets
+    // below (ABOVE: above) it to collected, counting the next level's digit of the keys it keeps; returns the end of
+    // the thread's keys in next
+    template<bool ABOVE>
+    static int compactBucket(const Key *__restrict candidates, const int begin, const int end, Key *__restrict next,
+                              Key *__restrict collected, const int shift, const int digitMask, const int keptBucket,
+                              int candidateOffset, int collectOffset, int *__restrict nextHistogram,
+                              const int nextDigitBits) {
+        const int nextShift = shift - nextDigitBits;
+        const int nextMask = (1 << nextDigitBits) - 1;
+        std::fill_n(nextHistogram, Sorter::NUM_BUCKETS, 0);
+
+        for (int i = begin; i < end; ++i) {
+            const Key key = candidates[i];
+            const int digit = Sorter::digitOf(key, shift, digitMask, 0);
+            if (digit == keptBucket) {
+                next[candidateOffset++] = key;
+                nextHistogram[Sorter::digitOf(key, nextShift, nextMask, 0)]++;
+            } else if (collected != nullptr && (ABOVE ? digit > keptBucket : digit < keptBucket)) {
+                collected[collectOffset++] = key;
+            }
+        }
+        return candidateOffset;
+    }
+};
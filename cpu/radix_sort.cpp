@@ -0,0 +1,241 @@
+#include "radix_sort.h"
+#include "radix_sorter.h"
+#include "radix_selector.h"
+#include "serial_radix_sort.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+static RadixSortThresholds thresholds;
+
+// 11-bit digits: a uniform input is down to n / 2048 candidates after the first level
+using Selector = RadixSelector<RadixSorter<int, 11>>;
+
+static bool isInstantiated(const RadixSortChoice &choice) {
+    if (choice.algorithm != RadixSortAlgorithm::PARALLEL_RADIX_SORT) {
+        return true;
+    }
+    return std::ranges::find(PARALLEL_DIGIT_BITS, choice.digitBits) != std::end(PARALLEL_DIGIT_BITS)
+           && std::ranges::find(PARALLEL_WRITE_BUFFER_SIZES, choice.writeBufferSize)
+              != std::end(PARALLEL_WRITE_BUFFER_SIZES);
+}
+
+static bool parseAlgorithm(const std::string &name, RadixSortAlgorithm &algorithm) {
+    for (const auto candidate: {
+             RadixSortAlgorithm::INSERTION_SORT, RadixSortAlgorithm::SERIAL_RADIX_SORT,
+             RadixSortAlgorithm::PARALLEL_RADIX_SORT
+         }) {
+        if (name == algorithmToString(candidate)) {
+            algorithm = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool readProfile(const std::string &path, RadixSortProfile &bands) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    RadixSortProfile parsed;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        std::string algorithm;
+        RadixSortBand band{};
+        fields >> band.maxSize >> algorithm >> band.choice.numThreads >> band.choice.digitBits
+                >> band.choice.writeBufferSize;
+        if (!fields || !parseAlgorithm(algorithm, band.choice.algorithm) || band.choice.numThreads < 1
+            || !isInstantiated(band.choice) || (!parsed.empty() && band.maxSize <= parsed.back().maxSize)) {
+            return false;
+        }
+        parsed.push_back(band);
+    }
+
+    bands = std::move(parsed);
+    return true;
+}
+
+// loaded from the environment's or the default profile file the first time it is used
+static RadixSortProfile &profile() {
+    static RadixSortProfile current = [] {
+        RadixSortProfile loaded;
+        const char *path = std::getenv(PROFILE_PATH_VARIABLE);
+        readProfile(path != nullptr ? path : DEFAULT_PROFILE_PATH, loaded);
+        return loaded;
+    }();
+    return current;
+}
+
+void setRadixSortThresholds(const RadixSortThresholds &newThresholds) {
+    thresholds = newThresholds;
+}
+
+const RadixSortThresholds &radixSortThresholds() {
+    return thresholds;
+}
+
+void setRadixSortProfile(RadixSortProfile newProfile) {
+    profile() = std::move(newProfile);
+}
+
+const RadixSortProfile &radixSortProfile() {
+    return profile();
+}
+
+bool loadRadixSortProfile(const std::string &path) {
+    return readProfile(path, profile());
+}
+
+bool saveRadixSortProfile(const std::string &path, const RadixSortProfile &bands) {
+    std::ofstream file(path);
+    file << "# radix_sort tuning profile, the first band whose maxSize holds n applies\n"
+            << "# maxSize algorithm threads digitBits writeBufferSize\n";
+    for (const auto &[maxSize, choice]: bands) {
+        file << maxSize << " " << algorithmToString(choice.algorithm) << " " << choice.numThreads << " "
+                << choice.digitBits << " " << choice.writeBufferSize << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+std::string algorithmToString(const RadixSortAlgorithm algorithm) {
+    switch (algorithm) {
+        case RadixSortAlgorithm::INSERTION_SORT:
+            return "insertion";
+        case RadixSortAlgorithm::SERIAL_RADIX_SORT:
+            return "serial";
+        case RadixSortAlgorithm::PARALLEL_RADIX_SORT:
+            return "parallel";
+        default:
+            return "unknown";
+    }
+}
+
+RadixSortChoice chooseRadixSort(const int n, const int numThreads) {
+    const RadixSortProfile &bands = profile();
+    if (!bands.empty()) {
+        const auto band = std::ranges::find_if(bands, [n](const RadixSortBand &b) { return n <= b.maxSize; });
+        RadixSortChoice choice = band != bands.end() ? band->choice : bands.back().choice;
+        choice.numThreads = std::min(choice.numThreads, numThreads);
+        if (choice.algorithm == RadixSortAlgorithm::PARALLEL_RADIX_SORT && choice.numThreads < 2) {
+            choice.algorithm = RadixSortAlgorithm::SERIAL_RADIX_SORT;
+        }
+        return choice;
+    }
+
+    if (n <= thresholds.insertionSortMaxSize) {
+        return {RadixSortAlgorithm::INSERTION_SORT, 1};
+    }
+
+    const int usefulThreads = std::min(numThreads, n / std::max(thresholds.parallelMinKeysPerThread, 1));
+    if (usefulThreads < 2) {
+        return {RadixSortAlgorithm::SERIAL_RADIX_SORT, 1};
+    }
+    return {RadixSortAlgorithm::PARALLEL_RADIX_SORT, usefulThreads};
+}
+
+static void insertionSort(int *arr, const int n) {
+    for (int i = 1; i < n; ++i) {
+        const int key = arr[i];
+        int j = i - 1;
+        while (j >= 0 && arr[j] > key) {
+            arr[j + 1] = arr[j];
+            --j;
+        }
+        arr[j + 1] = key;
+    }
+}
+
+// every instantiation keeps its own context per calling thread, sized for the caller's maxThreads and rebuilt only if
+// a later caller allows more; the thread count chosen for n (which shrinks with n) runs on the first of its threads
+template<int DigitBits, int WriteBufferSize>
+static void sortParallel(int *arr, const int n, const int numThreads, const int maxThreads) {
+    using Sorter = RadixSorter<int, DigitBits, WriteBufferSize, RadixFeatures::KeyRangeEarlyExit,
+        RadixFeatures::SkipTrivialPasses, RadixFeatures::PresortedRuns, RadixFeatures::LowCardinality>;
+
+    thread_local std::unique_ptr<RadixSortContext<Sorter>> context;
+    if (!context || context->numThreads() < maxThreads) {
+        context = std::make_unique<RadixSortContext<Sorter>>(n, maxThreads);
+    }
+    context->sort(arr, n, numThreads);
+}
+
+template<int DigitBits>
+static void sortParallel(int *arr, const int n, const RadixSortChoice &choice, const int maxThreads) {
+    if (choice.writeBufferSize == 64) {
+        sortParallel<DigitBits, 64>(arr, n, choice.numThreads, maxThreads);
+    } else {
+        sortParallel<DigitBits, 128>(arr, n, choice.numThreads, maxThreads);
+    }
+}
+
+void radix_sort(int *arr, const int n, const int numThreads) {
+    const RadixSortChoice choice = chooseRadixSort(n, numThreads);
+
+    switch (choice.algorithm) {
+        case RadixSortAlgorithm::INSERTION_SORT:
+            insertionSort(arr, n);
+            break;
+
+        case RadixSortAlgorithm::SERIAL_RADIX_SORT: {
+            thread_local std::vector<int> buffer;
+            if (buffer.size() < static_cast<size_t>(n)) {
+                buffer.resize(n);
+            }
+            SerialByteRadixSort::sort(arr, n, buffer.data());
+            break;
+        }
+
+        case RadixSortAlgorithm::PARALLEL_RADIX_SORT:
+            if (choice.digitBits == 11) {
+                sortParallel<11>(arr, n, choice, numThreads);
+            } else {
+                sortParallel<8>(arr, n, choice, numThreads);
+            }
+            break;
+    }
+}
+
+void segmented_sort(int *keys, const int *segmentOffsets, const int numSegments, const int numThreads) {
+    const auto isLarge = [&](const int segment) {
+        const int size = segmentOffsets[segment + 1] - segmentOffsets[segment];
+        return chooseRadixSort(size, numThreads).algorithm == RadixSortAlgorithm::PARALLEL_RADIX_SORT;
+    };
+
+    for (int segment = 0; segment < numSegments; ++segment) {
+        if (isLarge(segment)) {
+            radix_sort(keys + segmentOffsets[segment], segmentOffsets[segment + 1] - segmentOffsets[segment],
+                       numThreads);
+        }
+    }
+
+    // segment sizes are uneven, threads take small chunks of segments as they finish
+    #pragma omp parallel for schedule(dynamic, 32) num_threads(numThreads)
+    for (int segment = 0; segment < numSegments; ++segment) {
+        if (!isLarge(segment)) {
+            radix_sort(keys + segmentOffsets[segment], segmentOffsets[segment + 1] - segmentOffsets[segment], 1);
+        }
+    }
+}
+
+int radix_select(const int *arr, const int n, const int k, const int numThreads) {
+    return Selector::select(arr, n, k, numThreads);
+}
+
+void radix_topk(const int *arr, const int n, const int k, int *out, const int numThreads) {
+    Selector::largest(arr, n, k, out, numThreads);
+}
+
+void radix_partial_sort(const int *arr, const int n, const int k, int *out, const int numThreads) {
+    Selector::smallest(arr, n, k, out, numThreads);
+    radix_sort(out, k, numThreads);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// crossovers between the algorithms radix_sort picks from when no tuning profile is loaded; the defaults are rough
+// starting points, run `autotune` on the target host for a full profile, or `benchmark --calibrate-dispatch <threads>`
+// and pass its output to setRadixSortThresholds
+struct RadixSortThresholds {
+    // inputs up to this size are insertion sorted, radix passes cost more than they save below it
+    int insertionSortMaxSize = 32;
+    // every thread of a parallel sort gets at least this many keys, smaller inputs run on fewer threads and inputs
+    // too small for two run on the single-threaded radix sort
+    int parallelMinKeysPerThread = 1 << 15;
+};
+
+enum class RadixSortAlgorithm {
+    INSERTION_SORT,
+    SERIAL_RADIX_SORT,
+    PARALLEL_RADIX_SORT
+};
+
+// the parallel sorts are RadixSorter<int, digitBits, writeBufferSize, KeyRangeEarlyExit, SkipTrivialPasses,
+// PresortedRuns, LowCardinality>, one of the PARALLEL_DIGIT_BITS x PARALLEL_WRITE_BUFFER_SIZES instantiations
+constexpr int PARALLEL_DIGIT_BITS[] = {8, 11};
+constexpr int PARALLEL_WRITE_BUFFER_SIZES[] = {64, 128};
+
+struct RadixSortChoice {
+    RadixSortAlgorithm algorithm;
+    int numThreads;
+    int digitBits = 8;
+    int writeBufferSize = 128;
+};
+
+// the choice for inputs of up to maxSize keys
+struct RadixSortBand {
+    int maxSize;
+    RadixSortChoice choice;
+};
+
+// the bands of a host's tuning profile by ascending maxSize; the last band also takes every larger input
+using RadixSortProfile = std::vector<RadixSortBand>;
+
+// the profile radix_sort loads on first use: the file named by this environment variable, else DEFAULT_PROFILE_PATH
+// in the working directory; without either it falls back to the thresholds
+constexpr const char *PROFILE_PATH_VARIABLE = "RADIX_SORT_PROFILE";
+constexpr const char *DEFAULT_PROFILE_PATH = "radix_sort_profile.txt";
+
+void setRadixSortThresholds(const RadixSortThresholds &thresholds);
+
+const RadixSortThresholds &radixSortThresholds();
+
+// replaces the loaded profile, an empty profile switches back to the thresholds
+void setRadixSortProfile(RadixSortProfile profile);
+
+const RadixSortProfile &radixSortProfile();
+
+// one band per line: "maxSize algorithm threads digitBits writeBufferSize", algorithm being insertion, serial or
+// parallel; lines starting with # are comments. Returns false, keeping the current profile, if the file cannot be
+// read or a line does not parse or names a parallel configuration that is not instantiated
+bool loadRadixSortProfile(const std::string &path);
+
+bool saveRadixSortProfile(const std::string &path, const RadixSortProfile &profile);
+
+std::string algorithmToString(RadixSortAlgorithm algorithm);
+
+// the algorithm and configuration radix_sort uses for n keys with up to numThreads threads
+RadixSortChoice chooseRadixSort(int n, int numThreads);
+
+// sorts arr in place with whichever of insertion sort, SerialByteRadixSort and the parallel radix sorts the profile
+// (or the thresholds) picks for n, on up to numThreads threads; scratch is kept per calling thread, so repeated calls
+// do not allocate
+void radix_sort(int *arr, int n, int numThreads);
+
+// sorts each segment keys[segmentOffsets[s]:segmentOffsets[s + 1]] in place, for numSegments segments given by
+// numSegments + 1 ascending offsets: segments radix_sort would run in parallel are sorted one after another on all
+// numThreads threads, the rest are spread over the threads in one parallel region and sorted single-threaded, every
+// segment reusing its thread's radix_sort scratch
+void segmented_sort(int *keys, const int *segmentOffsets, int numSegments, int numThreads);
+
+// the key of rank k (0-based, the k-th smallest) of arr[0, n), which is left untouched; requires 0 <= k < n. Narrows
+// down one digit at a time with RadixSelector, reading arr about twice instead of sorting it.
+int radix_select(const int *arr, int n, int k, int numThreads);
+
+// the k largest keys of arr into out, in no particular order
+void radix_topk(const int *arr, int n, int k, int *out, int numThreads);
+
+// the k smallest keys of arr into out in ascending order, like std::partial_sort_copy: RadixSelector collects them,
+// then radix_sort sorts only those k
+void radix_partial_sort(const int *arr, int n, int k, int *out, int numThreads);
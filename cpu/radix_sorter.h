@@ -0,0 +1,1772 @@
+#pragma once
+
+#include "huge_page_array.h"
+
+#include <omp.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace RadixFeatures {
+    // compute the min and max key alongside the first histogram and skip the passes above the highest bit that
+    // differs between them (every key in [min, max] shares that prefix)
+    struct MaxBitsEarlyExit {};
+
+    // compute the min and max key alongside the first histogram and sort on (key - min), so that the passes are
+    // sized from bit_width(max - min) instead of the raw key width
+    struct KeyRangeEarlyExit {};
+
+    // count the histograms of every digit in the first read of the input (fused with the min/max scan) and have each
+    // scatter count the next digit for the thread that reads each key in the next pass, so every later pass is
+    // scatter-only; not combinable with KeyRangeEarlyExit, whose digits are unknown until the min is
+    struct FusedHistograms {};
+
+    // read the input for the first histogram only and have each scatter count the next pass's digit for the thread
+    // that reads each key in the next pass, so every later pass is scatter-only; unlike FusedHistograms the digits
+    // are counted once the pass plan is known, so it combines with KeyRangeEarlyExit and AdaptiveDigitWidth. A pass
+    // after a skipped trivial one reads its histogram again, the keys it was counted for did not move.
+    struct NextPassHistograms {};
+
+    // skip the scatter of any pass whose digit is the same for every key (a single non-empty bucket), leaving the
+    // keys where they are instead of copying them unchanged into the other buffer
+    struct SkipTrivialPasses {};
+
+    // treat DigitBits as the widest allowed digit and pick the width at runtime, once the key range is known, as the
+    // widest one whose per-thread scatter state fits the host's L1/L2 and that a thread's share of n can fill; a
+    // caller can pick among instantiations of several DigitBits with maxDigitBits first, so that the staging area and
+    // the kernels are compiled for the width that runs
+    struct AdaptiveDigitWidth {};
+
+    // split the keys with one parallel MSD pass on a top digit sized so that the buckets fit in L2, then have each
+    // thread finish whole buckets with serial LSD passes that stay in its cache (keys only)
+    struct HybridMsdLsd {};
+
+    // check the input order alongside the min/max scan (keys-only sorts): an already sorted input is left as it is, a
+    // non-increasing one is reversed, and one made of a few ascending runs is merged in parallel when the merge
+    // rounds cost less than the radix passes would; needs MaxBitsEarlyExit or KeyRangeEarlyExit
+    struct PresortedRuns {};
+
+    // sample the input first (keys-only sorts of arithmetic keys): when it holds only a few distinct keys, count each
+    // one in per-thread hash tables and rewrite the input as runs of equal keys, one read and one write whatever the
+    // key width; if the full count finds more distinct keys than the tables hold, the radix passes run as usual
+    struct LowCardinality {};
+
+    // flush the write-combining buffers of keys-only sorts with non-temporal stores of whole destination cache lines,
+    // which bypass the caches instead of pulling in lines that are not read again until the next pass; a partial
+    // line stays staged until it fills up. Only taken when the input outgrows the last-level cache and the target
+    // has SSE2 (the stores are as wide as the running CPU allows: 16, 32 or 64 bytes), otherwise the buffers are
+    // flushed with memcpy as usual. Keep WriteBufferSize small so that the
+    // staging area of all buckets fits in L1 (e.g. 16 int keys, one line per bucket)
+    struct StreamingStores {};
+}
+
+// the order a PresortedRuns sort found its input in
+enum class InputOrder {
+    UNSORTED,
+    SORTED,
+    REVERSED,
+    FEW_RUNS
+};
+
+// data cache sizes of the host in bytes, read once from sysconf with common values as the fallback
+struct CacheSizes {
+    long l1 = 32 * 1024;
+    long l2 = 1024 * 1024;
+    long l3 = 8 * 1024 * 1024;
+};
+
+inline const CacheSizes &hostCacheSizes() {
+    static const CacheSizes sizes = [] {
+        CacheSizes detected;
+        if (const long l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE); l1 > 0) {
+            detected.l1 = l1;
+        }
+        if (const long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE); l2 > 0) {
+            detected.l2 = l2;
+        }
+        if (const long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE); l3 > 0) {
+            detected.l3 = l3;
+        }
+        return detected;
+    }();
+    return sizes;
+}
+
+// digit counting kernels for 32-bit key patterns: the digit of bits[i] is ((bits[i] ^ flip) - offset) >> shift & mask,
+// and consecutive keys are counted into DIGIT_COUNT_COPIES interleaved histograms (counts[copy * stride + digit]) so
+// that a run of keys with the same digit does not stall every increment on the store of the one before. The caller
+// sums the copies.
+constexpr int DIGIT_COUNT_COPIES = 4;
+
+using DigitCountKernel = void (*)(const uint32_t *bits, int count, int *counts, int stride, uint32_t flip,
+                                  uint32_t offset, int shift, uint32_t mask);
+
+inline void countDigitsScalar(const uint32_t *__restrict bits, const int count, int *__restrict counts,
+                              const int stride, const uint32_t flip, const uint32_t offset, const int shift,
+                              const uint32_t mask) {
+    int i = 0;
+    for (; i + DIGIT_COUNT_COPIES <= count; i += DIGIT_COUNT_COPIES) {
+        for (int copy = 0; copy < DIGIT_COUNT_COPIES; ++copy) {
+            ++counts[copy * stride + (((bits[i + copy] ^ flip) - offset) >> shift & mask)];
+        }
+    }
+    for (; i < count; ++i) {
+        ++counts[((bits[i] ^ flip) - offset) >> shift & mask];
+    }
+}
+
+// x86-64 only: the lanes are moved out as 64-bit pairs (_mm_cvtsi128_si64), which 32-bit x86 has no instruction for
+#if defined(__x86_64__) && defined(__GNUC__)
+// counts the 8 digits of a vector, moved out to general registers as pairs rather than stored and reloaded
+__attribute__((target("avx2")))
+inline void countDigitLanes(const __m256i digits, int *__restrict counts, const int stride) {
+    const __m128i low = _mm256_castsi256_si128(digits);
+    const __m128i high = _mm256_extracti128_si256(digits, 1);
+    const auto pair0 = static_cast<uint64_t>(_mm_cvtsi128_si64(low));
+    const auto pair1 = static_cast<uint64_t>(_mm_extract_epi64(low, 1));
+    const auto pair2 = static_cast<uint64_t>(_mm_cvtsi128_si64(high));
+    const auto pair3 = static_cast<uint64_t>(_mm_extract_epi64(high, 1));
+    static_assert(DIGIT_COUNT_COPIES == 4, "lanes i and i + 4 share a copy");
+    ++counts[static_cast<uint32_t>(pair0)];
+    ++counts[stride + (pair0 >> 32)];
+    ++counts[2 * stride + static_cast<uint32_t>(pair1)];
+    ++counts[3 * stride + (pair1 >> 32)];
+    ++counts[static_cast<uint32_t>(pair2)];
+    ++counts[stride + (pair2 >> 32)];
+    ++counts[2 * stride + static_cast<uint32_t>(pair3)];
+    ++counts[3 * stride + (pair3 >> 32)];
+}
+
+// 8 digits per step extracted with AVX2 shifts and masks
+__attribute__((target("avx2")))
+inline void countDigitsAvx2(const uint32_t *__restrict bits, const int count, int *__restrict counts,
+                            const int stride, const uint32_t flip, const uint32_t offset, const int shift,
+                            const uint32_t mask) {
+    const __m256i flips = _mm256_set1_epi32(static_cast<int>(flip));
+    const __m256i offsets = _mm256_set1_epi32(static_cast<int>(offset));
+    const __m256i masks = _mm256_set1_epi32(static_cast<int>(mask));
+    const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bits + i));
+        lanes = _mm256_sub_epi32(_mm256_xor_si256(lanes, flips), offsets);
+        countDigitLanes(_mm256_and_si256(_mm256_srl_epi32(lanes, shiftCount), masks), counts, stride);
+    }
+    countDigitsScalar(bits + i, count - i, counts, stride, flip, offset, shift, mask);
+}
+
+// 16 digits per step with AVX-512F, counted as two halves of 8
+__attribute__((target("avx512f,avx2")))
+inline void countDigitsAvx512(const uint32_t *__restrict bits, const int count, int *__restrict counts,
+                              const int stride, const uint32_t flip, const uint32_t offset, const int shift,
+                              const uint32_t mask) {
+    const __m512i flips = _mm512_set1_epi32(static_cast<int>(flip));
+    const __m512i offsets = _mm512_set1_epi32(static_cast<int>(offset));
+    const __m512i masks = _mm512_set1_epi32(static_cast<int>(mask));
+    const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+    constexpr __mmask16 ALL_LANES = 0xffff;
+    constexpr __mmask8 ALL_QUADS = 0xff;
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i lanes = _mm512_loadu_si512(bits + i);
+        lanes = _mm512_sub_epi32(_mm512_xor_si512(lanes, flips), offsets);
+        // the zero-masking forms: the plain ones pass an undefined vector through and trip -Wmaybe-uninitialized
+        lanes = _mm512_and_si512(_mm512_maskz_srl_epi32(ALL_LANES, lanes, shiftCount), masks);
+        countDigitLanes(_mm512_maskz_extracti64x4_epi64(ALL_QUADS, lanes, 0), counts, stride);
+        countDigitLanes(_mm512_maskz_extracti64x4_epi64(ALL_QUADS, lanes, 1), counts, stride);
+    }
+    countDigitsScalar(bits + i, count - i, counts, stride, flip, offset, shift, mask);
+}
+#endif
+
+// the widest kernel the running CPU supports, picked once
+inline DigitCountKernel digitCountKernel() {
+    static const DigitCountKernel kernel = [] {
+#if defined(__x86_64__) && defined(__GNUC__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2")) {
+            return &countDigitsAvx512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return &countDigitsAvx2;
+        }
+#endif
+        return &countDigitsScalar;
+    }();
+    return kernel;
+}
+
+// StreamingStores: copies lineCount cache lines from src (any alignment) to dst (line-aligned) with non-temporal
+// stores, which the caller orders with an sfence before anyone reads dst
+using StreamLinesKernel = void (*)(void *dst, const void *src, int lineCount);
+
+#if defined(__SSE2__)
+inline void streamLinesSse2(void *dst, const void *src, const int lineCount) {
+    auto *out = static_cast<__m128i *>(dst);
+    const auto *in = static_cast<const __m128i *>(src);
+    for (int quarter = 0; quarter < 4 * lineCount; ++quarter) {
+        _mm_stream_si128(out + quarter, _mm_loadu_si128(in + quarter));
+    }
+}
+
+__attribute__((target("avx")))
+inline void streamLinesAvx(void *dst, const void *src, const int lineCount) {
+    auto *out = static_cast<__m256i *>(dst);
+    const auto *in = static_cast<const __m256i *>(src);
+    for (int half = 0; half < 2 * lineCount; ++half) {
+        _mm256_stream_si256(out + half, _mm256_loadu_si256(in + half));
+    }
+}
+
+__attribute__((target("avx512f")))
+inline void streamLinesAvx512(void *dst, const void *src, const int lineCount) {
+    auto *out = static_cast<__m512i *>(dst);
+    const auto *in = static_cast<const __m512i *>(src);
+    for (int line = 0; line < lineCount; ++line) {
+        _mm512_stream_si512(out + line, _mm512_loadu_si512(in + line));
+    }
+}
+
+// the widest non-temporal store the running CPU supports, picked once
+inline StreamLinesKernel streamLinesKernel() {
+    static const StreamLinesKernel kernel = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return &streamLinesAvx512;
+        }
+        if (__builtin_cpu_supports("avx")) {
+            return &streamLinesAvx;
+        }
+        return &streamLinesSse2;
+    }();
+    return kernel;
+}
+#endif
+
+// what the most recent sort on the calling thread did, for reporting
+struct RadixSortStats {
+    int passesScattered = 0;
+    int passesSkipped = 0;
+
+    // the digit widths the key range was split into, lowest digit first (skipped passes included)
+    int numPlannedPasses = 0;
+    std::array<int, 64> passWidths{};
+
+    // PresortedRuns: anything but UNSORTED was handled without radix passes, FEW_RUNS by merging numRuns runs
+    InputOrder inputOrder = InputOrder::UNSORTED;
+    int numRuns = 0;
+
+    // LowCardinality: the distinct keys of an input that was counting sorted, 0 when it was radix sorted
+    int numDistinct = 0;
+
+    // StreamingStores: the scatters wrote whole cache lines with non-temporal stores
+    bool streamedStores = false;
+};
+
+inline thread_local RadixSortStats lastRadixSortStats;
+
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+// arrays that start on a cache line, so that rows padded to whole lines never straddle one
+template<typename T>
+struct AlignedArrayDelete {
+    void operator()(T *array) const {
+        ::operator delete[](array, std::align_val_t{CACHE_LINE_SIZE});
+    }
+};
+
+template<typename T>
+using AlignedArray = std::unique_ptr<T[], AlignedArrayDelete<T>>;
+
+// uninitialized, like make_unique_for_overwrite
+template<typename T>
+AlignedArray<T> makeAlignedArray(const std::size_t count) {
+    static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>);
+    return AlignedArray<T>(static_cast<T *>(::operator new[](count * sizeof(T), std::align_val_t{CACHE_LINE_SIZE})));
+}
+
+// maps a key to the unsigned bit pattern whose digits are sorted on, flipping the sign bit of signed keys so that
+// negatives order before positives without an extra pass over the data
+template<typename Key>
+struct RadixKeyTraits {
+    using Bits = std::make_unsigned_t<Key>;
+
+    static constexpr Bits SIGN_FLIP = std::is_signed_v<Key> ? Bits{1} << (sizeof(Key) * 8 - 1) : Bits{0};
+
+    static Bits toBits(const Key key) {
+        return static_cast<Bits>(key) ^ SIGN_FLIP;
+    }
+};
+
+// IEEE-754 keys: positives get the sign bit set and negatives are fully inverted, so that unsigned order of the bits
+// is the IEEE totalOrder of the values. The transform happens inside digit extraction, not as a separate pass:
+// - -0.0 sorts immediately before +0.0
+// - NaNs with the sign bit clear sort after +inf, NaNs with the sign bit set (e.g. 0.0 / 0.0 on x86) before -inf
+template<typename Float, typename UInt>
+struct RadixFloatTraits {
+    static_assert(sizeof(Float) == sizeof(UInt) && std::numeric_limits<Float>::is_iec559);
+
+    using Bits = UInt;
+
+    static constexpr Bits SIGN_BIT = Bits{1} << (sizeof(Bits) * 8 - 1);
+
+    static Bits toBits(const Float key) {
+        const auto bits = std::bit_cast<Bits>(key);
+        return bits ^ ((bits & SIGN_BIT) ? ~Bits{0} : SIGN_BIT);
+    }
+};
+
+template<>
+struct RadixKeyTraits<float> : RadixFloatTraits<float, uint32_t> {};
+
+template<>
+struct RadixKeyTraits<double> : RadixFloatTraits<double, uint64_t> {};
+
+// a 32-bit key and a 32-bit value fused into one word with the key bits on top, so that a key-value pair is
+// scattered as a single 8-byte stream instead of two
+struct PackedKeyValue {
+    uint64_t word;
+
+    static PackedKeyValue pack(const int key, const uint32_t value) {
+        return {static_cast<uint64_t>(RadixKeyTraits<int>::toBits(key)) << 32 | value};
+    }
+
+    int key() const {
+        return static_cast<int>(static_cast<uint32_t>(word >> 32) ^ RadixKeyTraits<int>::SIGN_FLIP);
+    }
+
+    uint32_t value() const {
+        return static_cast<uint32_t>(word);
+    }
+};
+
+template<>
+struct RadixKeyTraits<PackedKeyValue> {
+    using Bits = uint32_t;
+
+    static Bits toBits(const PackedKeyValue pair) {
+        return static_cast<Bits>(pair.word >> 32);
+    }
+};
+
+template<typename Sorter>
+class RadixSortContext;
+
+template<typename Sorter>
+class RadixSelector;
+
+// LSD radix sort engine shared by every parallel sorter:
+// - DigitBits:       bits sorted per pass (NUM_BUCKETS = 2^DigitBits)
+// - WriteBufferSize: keys staged per bucket before flushing to the output (0 scatters directly)
+// - Features:        optional tags from RadixFeatures
+template<typename Key, int DigitBits, int WriteBufferSize = 0, typename... Features>
+class RadixSorter {
+    static_assert(DigitBits >= 1 && DigitBits <= 16, "digit width must be between 1 and 16 bits");
+    static_assert(WriteBufferSize >= 0, "write buffer size must not be negative");
+
+public:
+    using KeyType = Key;
+    using Bits = typename RadixKeyTraits<Key>::Bits;
+
+    static constexpr int KEY_BITS = sizeof(Bits) * 8;
+    static constexpr int NUM_BUCKETS = 1 << DigitBits;
+
+    template<typename Feature>
+    static constexpr bool HAS_FEATURE = (std::is_same_v<Feature, Features> || ...);
+
+    static constexpr bool EARLY_EXIT = HAS_FEATURE<RadixFeatures::MaxBitsEarlyExit>;
+    static constexpr bool KEY_RANGE = HAS_FEATURE<RadixFeatures::KeyRangeEarlyExit>;
+    static constexpr bool FUSED_HISTOGRAMS = HAS_FEATURE<RadixFeatures::FusedHistograms>;
+    static constexpr bool NEXT_PASS_HISTOGRAMS = HAS_FEATURE<RadixFeatures::NextPassHistograms>;
+    static constexpr bool COUNT_IN_SCATTER = FUSED_HISTOGRAMS || NEXT_PASS_HISTOGRAMS;
+    static constexpr bool SKIP_TRIVIAL_PASSES = HAS_FEATURE<RadixFeatures::SkipTrivialPasses>;
+    static constexpr bool ADAPTIVE_DIGIT_WIDTH = HAS_FEATURE<RadixFeatures::AdaptiveDigitWidth>;
+    static constexpr bool HYBRID_MSD_LSD = HAS_FEATURE<RadixFeatures::HybridMsdLsd>;
+    static constexpr bool PRESORTED_RUNS = HAS_FEATURE<RadixFeatures::PresortedRuns>;
+    static constexpr bool LOW_CARDINALITY = HAS_FEATURE<RadixFeatures::LowCardinality>;
+#if defined(__SSE2__)
+    static constexpr bool STREAMING_STORES = HAS_FEATURE<RadixFeatures::StreamingStores>;
+#else
+    static constexpr bool STREAMING_STORES = false;
+#endif
+    static constexpr bool SCAN_MIN_MAX = EARLY_EXIT || KEY_RANGE;
+
+    static constexpr int MAX_PASSES = (KEY_BITS + DigitBits - 1) / DigitBits;
+
+    // PresortedRuns: inputs of more ascending runs than this are radix sorted
+    static constexpr int MAX_MERGED_RUNS = 16;
+
+    // LowCardinality: every thread counts up to MAX_DISTINCT keys in a table of twice as many slots; inputs of at
+    // least LOW_CARDINALITY_MIN_SIZE keys are sampled at CARDINALITY_SAMPLE_SIZE evenly spaced positions and counted
+    // when the sample holds at most half of MAX_DISTINCT distinct keys
+    static constexpr int MAX_DISTINCT = 1024;
+    static constexpr int DISTINCT_TABLE_SIZE = 2 * MAX_DISTINCT;
+    static constexpr int CARDINALITY_SAMPLE_SIZE = 4096;
+    static constexpr int LOW_CARDINALITY_MIN_SIZE = 16 * CARDINALITY_SAMPLE_SIZE;
+
+    static_assert(!(FUSED_HISTOGRAMS && KEY_RANGE), "fused histograms count raw digits, the min is not known yet");
+    static_assert(!FUSED_HISTOGRAMS || DigitBits <= 12, "fused histograms keep numThreads^2 histograms per pass");
+    static_assert(!(FUSED_HISTOGRAMS && ADAPTIVE_DIGIT_WIDTH), "fused histograms count DigitBits-aligned digits");
+    static_assert(!(FUSED_HISTOGRAMS && HYBRID_MSD_LSD), "the hybrid sort has a single parallel pass");
+    static_assert(!(FUSED_HISTOGRAMS && NEXT_PASS_HISTOGRAMS), "the fused histograms already count every digit");
+    static_assert(!NEXT_PASS_HISTOGRAMS || DigitBits <= 12, "next-pass counts keep numThreads^2 histograms");
+    static_assert(!(NEXT_PASS_HISTOGRAMS && HYBRID_MSD_LSD), "the hybrid sort has a single parallel pass");
+    static_assert(!PRESORTED_RUNS || (SCAN_MIN_MAX && !FUSED_HISTOGRAMS && !HYBRID_MSD_LSD),
+                  "the input order is checked in the plain min/max scan of the first pass");
+    static_assert(!LOW_CARDINALITY || std::is_arithmetic_v<Key>, "equal bits must mean equal keys to count them");
+    static_assert(!HAS_FEATURE<RadixFeatures::StreamingStores> ||
+                  (WriteBufferSize > 0 && CACHE_LINE_SIZE % sizeof(Key) == 0 &&
+                   WriteBufferSize * sizeof(Key) % CACHE_LINE_SIZE == 0),
+                  "streaming stores write whole cache lines of staged keys");
+
+    // sorts into outputArray, inputArray is used as the ping-pong buffer and is clobbered
+    static void sort(Key *inputArray, Key *outputArray, const int n, const int numThreads) {
+        const Key *result = sortBuffers(inputArray, outputArray, n, numThreads);
+        if (result != outputArray) {
+            parallelCopy(outputArray, result, n, numThreads);
+        }
+    }
+
+    // sorts into outputArray without touching inputArray, at the cost of an extra n-element buffer
+    static void sortPreservingInput(const Key *inputArray, Key *outputArray, const int n, const int numThreads) {
+        parallelCopy(outputArray, inputArray, n, numThreads);
+
+        const auto buffer = makeHugePageArray<Key>(n, 0);
+        const Key *result = sortBuffers(outputArray, buffer.get(), n, numThreads);
+        if (result != outputArray) {
+            parallelCopy(outputArray, result, n, numThreads);
+        }
+    }
+
+    // sorts keys and permutes values alongside them (stable), both arrays are sorted in place
+    template<typename Value>
+    static void sortPairs(Key *keys, Value *values, const int n, const int numThreads) {
+        const auto keyBuffer = makeHugePageArray<Key>(n, 0);
+        const auto valueBuffer = makeHugePageArray<Value>(n, 0);
+
+        const Key *result = sortPairBuffers(keys, keyBuffer.get(), values, valueBuffer.get(), n, numThreads);
+        if (result != keys) {
+            parallelCopy(keys, keyBuffer.get(), n, numThreads);
+            parallelCopy(values, valueBuffer.get(), n, numThreads);
+        }
+    }
+
+    // writes the permutation that stably sorts keys into indices (keys[indices[0]] is the smallest key); keys are
+    // only read, and the last pass scatters the indices alone instead of writing a sorted copy of the keys
+    static void argsort(const Key *keys, uint32_t *indices, const int n, const int numThreads) {
+        if (n <= 1) {
+            std::fill_n(indices, n, 0u);
+            return;
+        }
+
+        const auto keyBuffers = makeHugePageArray<Key>(2 * static_cast<size_t>(n), 0);
+        const auto indexBuffer = makeHugePageArray<uint32_t>(n, 0);
+
+        runPasses<uint32_t, true>(const_cast<Key *>(keys), keyBuffers.get(), keyBuffers.get() + n, indexBuffer.get(),
+                                  indices, n, Workspace<uint32_t>(numThreads));
+    }
+
+    // sorts arr using buffer as scratch, returns whichever of the two holds the sorted keys
+    static Key *sortBuffers(Key *arr, Key *buffer, const int n, const int numThreads) {
+        return sortPairBuffers<void>(arr, buffer, nullptr, nullptr, n, numThreads);
+    }
+
+    // as sortBuffers, moving values through the same offsets and write-combining buffers as their keys; the sorted
+    // values end up in values if the returned pointer is arr, in valueBuffer otherwise (Value = void sorts keys only)
+    template<typename Value>
+    static Key *sortPairBuffers(Key *arr, Key *buffer, Value *values, Value *valueBuffer, const int n,
+                                const int numThreads) {
+        if (n <= 1) {
+            return arr;
+        }
+
+        return sortPairBuffers(arr, buffer, values, valueBuffer, n, Workspace<Value>(numThreads));
+    }
+
+    // AdaptiveDigitWidth: the widest digit up to DigitBits the plan of a sort of n keys on numThreads threads allows,
+    // for callers that dispatch each width to an instantiation compiled for it
+    static int maxDigitBits(const int n, const int numThreads) {
+        return planMaxDigitBits(n, numThreads);
+    }
+
+private:
+    template<typename Sorter>
+    friend class RadixSortContext;
+
+    template<typename Sorter>
+    friend class RadixSelector;
+
+    // per-thread rows are padded to whole cache lines so neighbouring threads never share one
+    static constexpr int THREAD_STRIDE = (NUM_BUCKETS + 15) & ~15;
+
+    // digit width of each pass, lowest digit first; narrower digits than DigitBits can take up to one pass per bit
+    using PassPlan = std::array<int, KEY_BITS>;
+
+    // element type of the value staging buffers, a placeholder when sorting keys only
+    template<typename Value>
+    using ValueSlot = std::conditional_t<std::is_void_v<Value>, char, Value>;
+
+    // LowCardinality: a distinct key and its count, then the position its run starts at
+    struct DistinctKey {
+        Key key;
+        int count;
+    };
+
+    // per-thread slices of the workspace handed to the scatter kernels
+    template<typename Value>
+    struct ThreadScratch {
+        int *offsets;
+        Key *stagedKeys;
+        ValueSlot<Value> *stagedValues;
+        int *stagedCounts;
+        int *nextCounts;
+        int prefetchDistance;
+    };
+
+    // scratch shared by all passes of one sort, every array cache-line aligned; each kernel clears or overwrites its
+    // part before reading it, so the arrays are left uninitialized and a workspace can be reused across sorts
+    template<typename Value>
+    struct Workspace {
+        AlignedArray<Bits> threadLocalMin;
+        AlignedArray<Bits> threadLocalMax;
+        AlignedArray<int> localHistograms;
+        AlignedArray<int> threadOffsets;
+        AlignedArray<int> globalHistogram;
+        AlignedArray<int> prefixSums;
+        AlignedArray<Key> stagedKeys;
+        AlignedArray<ValueSlot<Value>> stagedValues;
+        AlignedArray<int> stagedCounts;
+
+        // FusedHistograms: per-thread histograms of every digit from the first read, their global sums, and for each
+        // writer thread the next digit's counts split by the thread that reads each key in the next pass (the latter
+        // also for NextPassHistograms)
+        AlignedArray<int> digitHistograms;
+        AlignedArray<int> digitGlobalHistograms;
+        AlignedArray<int> nextCounts;
+
+        // PresortedRuns: per thread the ascents and descents between neighbouring keys its first read saw and, for
+        // few runs, the descent positions; then the first index of every run to merge followed by n
+        AlignedArray<int> threadAscents;
+        AlignedArray<int> threadDescents;
+        AlignedArray<int> threadRunStarts;
+        AlignedArray<int> runStarts;
+
+        // LowCardinality: per thread an open-addressing table of keys and their counts (a zero count is an empty
+        // slot), then every thread's keys merged in key order, each with the position its run starts at
+        AlignedArray<Key> distinctKeys;
+        AlignedArray<int> distinctCounts;
+        AlignedArray<DistinctKey> mergedDistinct;
+
+        // the threads the arrays are sized for, and the threads the next sort runs on: any count up to maxThreads
+        // fits in them, so a reused workspace can sort small inputs on fewer threads
+        const int maxThreads;
+        int numThreads;
+
+        // how far ahead the scatters prefetch, in keys; 0 leaves it to the hardware prefetchers
+        int prefetchDistance = 0;
+
+        explicit Workspace(const int numThreads)
+            : threadLocalMin(makeAlignedArray<Bits>(numThreads)),
+              threadLocalMax(makeAlignedArray<Bits>(numThreads)),
+              localHistograms(makeAlignedArray<int>(numThreads * THREAD_STRIDE)),
+              threadOffsets(makeAlignedArray<int>(numThreads * THREAD_STRIDE)),
+              globalHistogram(makeAlignedArray<int>(NUM_BUCKETS)),
+              prefixSums(makeAlignedArray<int>(NUM_BUCKETS)),
+              maxThreads(numThreads),
+              numThreads(numThreads) {
+            if constexpr (WriteBufferSize > 0) {
+                stagedKeys = makeAlignedArray<Key>(numThreads * NUM_BUCKETS * WriteBufferSize);
+                stagedCounts = makeAlignedArray<int>(numThreads * THREAD_STRIDE);
+                if constexpr (!std::is_void_v<Value>) {
+                    stagedValues = makeAlignedArray<Value>(numThreads * NUM_BUCKETS * WriteBufferSize);
+                }
+            }
+            if constexpr (FUSED_HISTOGRAMS) {
+                digitHistograms = makeAlignedArray<int>(numThreads * MAX_PASSES * THREAD_STRIDE);
+                digitGlobalHistograms = makeAlignedArray<int>(MAX_PASSES * NUM_BUCKETS);
+            }
+            if constexpr (COUNT_IN_SCATTER) {
+                nextCounts = makeAlignedArray<int>(numThreads * numThreads * THREAD_STRIDE);
+            }
+            if constexpr (PRESORTED_RUNS && std::is_void_v<Value>) {
+                threadAscents = makeAlignedArray<int>(numThreads);
+                threadDescents = makeAlignedArray<int>(numThreads);
+                threadRunStarts = makeAlignedArray<int>(numThreads * MAX_MERGED_RUNS);
+                runStarts = makeAlignedArray<int>(MAX_MERGED_RUNS + 1);
+            }
+            if constexpr (LOW_CARDINALITY && std::is_void_v<Value>) {
+                distinctKeys = makeAlignedArray<Key>(numThreads * DISTINCT_TABLE_SIZE);
+                distinctCounts = makeAlignedArray<int>(numThreads * DISTINCT_TABLE_SIZE);
+                mergedDistinct = makeAlignedArray<DistinctKey>(numThreads * MAX_DISTINCT);
+            }
+        }
+
+        int *localHistogram(const int tid) const {
+            return &localHistograms[tid * THREAD_STRIDE];
+        }
+
+        // the scatter's counts for the next pass are laid out per writer and reader of the team actually running, the
+        // same teamSize stride gatherNextCounts reads them with
+        ThreadScratch<Value> threadScratch(const int tid, const int teamSize) const {
+            const int stagingBegin = tid * NUM_BUCKETS * WriteBufferSize;
+            return {
+                &threadOffsets[tid * THREAD_STRIDE],
+                stagedKeys ? &stagedKeys[stagingBegin] : nullptr,
+                stagedValues ? &stagedValues[stagingBegin] : nullptr,
+                stagedCounts ? &stagedCounts[tid * THREAD_STRIDE] : nullptr,
+                nextCounts ? &nextCounts[tid * teamSize * THREAD_STRIDE] : nullptr,
+                prefetchDistance
+            };
+        }
+    };
+
+    // sortPairBuffers on a workspace that may be reused across sorts
+    template<typename Value>
+    static Key *sortPairBuffers(Key *arr, Key *buffer, Value *values, Value *valueBuffer, const int n,
+                                const Workspace<Value> &workspace) {
+        if (n <= 1) {
+            return arr;
+        }
+
+        if constexpr (LOW_CARDINALITY && std::is_void_v<Value>) {
+            if (n >= LOW_CARDINALITY_MIN_SIZE && hasFewDistinctKeys(arr, n) && countingSort(arr, n, workspace)) {
+                return arr;
+            }
+        }
+
+        if constexpr (HYBRID_MSD_LSD) {
+            static_assert(std::is_void_v<Value>, "the hybrid sort moves keys only");
+            return runHybrid(arr, buffer, n, workspace);
+        } else {
+            return runPasses<Value, false>(arr, buffer, nullptr, values, valueBuffer, n, workspace);
+        }
+    }
+
+    // the pass loop behind every entry point, run in one parallel region of workspace.numThreads threads: keys
+    // ping-pong between arr and buffer, values between values and valueBuffer, and the array holding the sorted keys
+    // is returned.
+    // ARGSORT: arr holds the caller's read-only keys and the values are key indices. The first pass reads arr and
+    // generates the indices itself, later passes ping-pong the keys between buffer and spareBuffer, and the last pass
+    // drops the keys and writes the indices into valueBuffer.
+    // SkipTrivialPasses: a skipped pass swaps no buffers, so the result location follows the scattered passes only.
+    // Argsort never skips, its index generation and destination parity are tied to the first and last pass.
+    // PresortedRuns: the first read also classifies the input order; a presorted input leaves the pass loop after the
+    // first histogram and is finished in place (reversed) or by merge rounds that ping-pong like the passes.
+    // NextPassHistograms: a pass whose keys the previous scatter counted gathers its histogram from those counts
+    // instead of reading the keys.
+    template<typename Value, bool ARGSORT>
+    static Key *runPasses(Key *arr, Key *buffer, Key *spareBuffer, Value *values, Value *valueBuffer, const int n,
+                          const Workspace<Value> &workspace) {
+        int numBits = KEY_BITS;
+        Bits keyOffset = 0;
+        PassPlan passWidths;
+        int numPasses = planPasses(numBits, n, workspace.numThreads, passWidths);
+
+        constexpr bool SKIP_TRIVIAL = SKIP_TRIVIAL_PASSES && !ARGSORT;
+        constexpr bool CHECK_ORDER = PRESORTED_RUNS && std::is_void_v<Value> && !ARGSORT;
+        // StreamingStores: bypassing the caches only pays once the keys and the buffer no longer fit in them
+        const bool streamStores = STREAMING_STORES && std::is_void_v<Value> &&
+                                  2L * n * static_cast<long>(sizeof(Key)) > hostCacheSizes().l3;
+        RadixSortStats stats;
+        bool skipScatter = false;
+        int nextShift = 0;
+
+        // FusedHistograms: every digit's global histogram is known after the first read, so the trivial passes are
+        // known up front. Every thread steps over them without a barrier, the scatter before them counts the digit of
+        // the next pass that runs, and until the first scatter moves the keys the first read's own counts stay valid.
+        std::array<bool, MAX_PASSES> trivialPasses{};
+        bool keysMoved = false;
+
+        // the loop state read by every thread (numBits, passWidths, the buffers) only changes inside single blocks,
+        // whose closing barrier publishes it before any thread reads it again
+        #pragma omp parallel num_threads(workspace.numThreads) proc_bind(close) default(none) shared(arr, buffer, spareBuffer, values, valueBuffer, n, numBits, keyOffset, passWidths, numPasses, workspace, stats, skipScatter, nextShift, trivialPasses, keysMoved, streamStores)
+        {
+            const int tid = omp_get_thread_num();
+            const int teamSize = omp_get_num_threads();
+            const auto [begin, end] = threadRange(n, tid, teamSize);
+            int *localHistogram = workspace.localHistogram(tid);
+            int *digitHistograms = FUSED_HISTOGRAMS
+                                       ? &workspace.digitHistograms[tid * MAX_PASSES * THREAD_STRIDE]
+                                       : nullptr;
+            const ThreadScratch<Value> scratch = workspace.threadScratch(tid, teamSize);
+            bool nextCounted = false;
+
+            for (int pass = 0, shift = 0; shift < numBits; shift += passWidths[pass++]) {
+                if (FUSED_HISTOGRAMS && SKIP_TRIVIAL && trivialPasses[pass]) {
+                    if (tid == 0) {
+                        ++stats.passesSkipped;
+                    }
+                    continue;
+                }
+
+                if (FUSED_HISTOGRAMS && pass == 0) {
+                    computeLocalDigitHistograms(arr, begin, end, digitHistograms, workspace.threadLocalMin[tid],
+                                                workspace.threadLocalMax[tid]);
+                    std::memcpy(localHistogram, digitHistograms, NUM_BUCKETS * sizeof(int));
+                } else if (FUSED_HISTOGRAMS && !keysMoved) {
+                    std::memcpy(localHistogram, &digitHistograms[pass * THREAD_STRIDE], NUM_BUCKETS * sizeof(int));
+                } else if (FUSED_HISTOGRAMS || nextCounted) {
+                    gatherNextCounts(workspace.nextCounts.get(), localHistogram, tid, teamSize);
+                } else if (CHECK_ORDER && pass == 0) {
+                    computeLocalHistogramsWithMinMax<true>(arr, begin, end, localHistogram,
+                                                           workspace.threadLocalMin[tid], workspace.threadLocalMax[tid],
+                                                           &workspace.threadAscents[tid],
+                                                           &workspace.threadDescents[tid]);
+                } else if (SCAN_MIN_MAX && pass == 0) {
+                    computeLocalHistogramsWithMinMax<false>(arr, begin, end, localHistogram,
+                                                            workspace.threadLocalMin[tid],
+                                                            workspace.threadLocalMax[tid]);
+                } else {
+                    computeLocalHistograms(arr, begin, end, localHistogram, shift, (1 << passWidths[pass]) - 1,
+                                           keyOffset);
+                }
+
+                #pragma omp barrier
+
+                #pragma omp single
+                {
+                    if (SCAN_MIN_MAX && pass == 0) {
+                        const auto [globalMin, globalMax] = reduceMinMax(workspace.threadLocalMin.get(),
+                                                                         workspace.threadLocalMax.get(), teamSize);
+                        if constexpr (KEY_RANGE) {
+                            keyOffset = globalMin;
+                            numBits = computeNumBits(globalMax - globalMin);
+                            rebaseLocalHistograms(workspace.localHistograms.get(), globalMin, teamSize);
+                        } else {
+                            numBits = computeNumBits(globalMin ^ globalMax);
+                        }
+                        numPasses = planPasses(numBits, n, teamSize, passWidths);
+                        foldLocalHistograms(workspace.localHistograms.get(), passWidths[0], teamSize);
+                        if constexpr (CHECK_ORDER) {
+                            stats.inputOrder = classifyInputOrder(workspace, teamSize, numPasses, stats.numRuns);
+                        }
+                    }
+
+                    // pick the first index destination so that the last pass lands in the caller's array
+                    if (ARGSORT && pass == 0 && numPasses % 2 == 0) {
+                        std::swap(values, valueBuffer);
+                    }
+
+                    int *globalHistogram = workspace.globalHistogram.get();
+                    if constexpr (FUSED_HISTOGRAMS) {
+                        if (pass == 0) {
+                            computeDigitGlobalHistograms(workspace.digitHistograms.get(),
+                                                         workspace.digitGlobalHistograms.get(), teamSize);
+                            for (int digit = 0; SKIP_TRIVIAL && digit * DigitBits < numBits; ++digit) {
+                                trivialPasses[digit] = isTrivialHistogram(
+                                    &workspace.digitGlobalHistograms[digit * NUM_BUCKETS], n);
+                            }
+                        }
+                        globalHistogram = &workspace.digitGlobalHistograms[pass * NUM_BUCKETS];
+                    } else {
+                        computeGlobalHistogram(workspace.localHistograms.get(), globalHistogram, teamSize);
+                    }
+
+                    skipScatter = SKIP_TRIVIAL && isTrivialHistogram(globalHistogram, n);
+                    nextShift = shift + passWidths[pass];
+                    while (FUSED_HISTOGRAMS && nextShift < numBits && trivialPasses[nextShift / DigitBits]) {
+                        nextShift += DigitBits;
+                    }
+
+                    if (!skipScatter) {
+                        computePrefixSums(globalHistogram, workspace.prefixSums.get());
+                        computeThreadOffsets(workspace.localHistograms.get(), workspace.prefixSums.get(),
+                                             workspace.threadOffsets.get(), teamSize);
+                    }
+                }
+
+                if (CHECK_ORDER && stats.inputOrder != InputOrder::UNSORTED) {
+                    break;
+                }
+
+                const int digitMask = (1 << passWidths[pass]) - 1;
+                const bool firstPass = pass == 0;
+                const bool lastPass = nextShift >= numBits;
+                const int nextDigitMask = FUSED_HISTOGRAMS || lastPass ? NUM_BUCKETS - 1
+                                                                       : (1 << passWidths[pass + 1]) - 1;
+                nextCounted = NEXT_PASS_HISTOGRAMS && !skipScatter && !lastPass;
+                if (skipScatter) {
+                    // every key stays where it is
+                } else if (firstPass && lastPass) {
+                    scatterToBuffer<ARGSORT, true, true>(arr, values, n, begin, end, buffer, valueBuffer, scratch,
+                                                         shift, digitMask, nextShift, nextDigitMask, keyOffset,
+                                                         streamStores);
+                } else if (firstPass) {
+                    scatterToBuffer<ARGSORT, true, false>(arr, values, n, begin, end, buffer, valueBuffer, scratch,
+                                                          shift, digitMask, nextShift, nextDigitMask, keyOffset,
+                                                          streamStores);
+                } else if (lastPass) {
+                    scatterToBuffer<ARGSORT, false, true>(arr, values, n, begin, end, buffer, valueBuffer, scratch,
+                                                          shift, digitMask, nextShift, nextDigitMask, keyOffset,
+                                                          streamStores);
+                } else {
+                    scatterToBuffer<ARGSORT, false, false>(arr, values, n, begin, end, buffer, valueBuffer, scratch,
+                                                           shift, digitMask, nextShift, nextDigitMask, keyOffset,
+                                                           streamStores);
+                }
+
+                #pragma omp barrier
+
+                #pragma omp single
+                {
+                    if (skipScatter) {
+                        ++stats.passesSkipped;
+                    } else {
+                        std::swap(arr, buffer);
+                        std::swap(values, valueBuffer);
+                        if (ARGSORT && pass == 0) {
+                            buffer = spareBuffer;
+                        }
+                        keysMoved = true;
+                        ++stats.passesScattered;
+                    }
+                }
+            }
+
+            if constexpr (CHECK_ORDER) {
+                if (stats.inputOrder == InputOrder::REVERSED) {
+                    reverseInPlace(arr, n, tid, teamSize);
+                }
+
+                // the first read only counted the runs, only now that there are few is it worth finding them
+                if (stats.inputOrder == InputOrder::FEW_RUNS) {
+                    findLocalRunStarts(arr, begin, end, &workspace.threadRunStarts[tid * MAX_MERGED_RUNS]);
+
+                    #pragma omp barrier
+
+                    #pragma omp single
+                    gatherRunStarts(workspace, n, teamSize);
+                }
+
+                // pairs of neighbouring runs merge into one per round, every merge split evenly over the team
+                for (int numRuns = stats.inputOrder == InputOrder::FEW_RUNS ? stats.numRuns : 1; numRuns > 1;
+                     numRuns = (numRuns + 1) / 2) {
+                    mergeRunPairs(arr, buffer, workspace.runStarts.get(), numRuns, tid, teamSize);
+
+                    #pragma omp barrier
+
+                    #pragma omp single
+                    {
+                        std::swap(arr, buffer);
+                        halveRunStarts(workspace.runStarts.get(), numRuns);
+                    }
+                }
+            }
+        }
+
+        stats.numPlannedPasses = numPasses;
+        std::copy_n(passWidths.begin(), numPasses, stats.passWidths.begin());
+        stats.streamedStores = streamStores && stats.passesScattered > 0;
+        lastRadixSortStats = stats;
+        return arr;
+    }
+
+    // HybridMsdLsd: a min/max scan sizes the key range, one parallel MSD pass scatters arr into buffer by the top
+    // digit, and the threads take whole buckets and finish them with serial LSD passes over the remaining low bits,
+    // ping-ponging between the bucket's span of buffer and arr while it is cache-resident. Every bucket runs the same
+    // LSD passes, so all of them end up in the same array, which is returned.
+    static Key *runHybrid(Key *arr, Key *buffer, const int n, const Workspace<void> &workspace) {
+        void *const noValues = nullptr;
+        Bits keyOffset = 0;
+        int msdBits = 0;
+        int msdShift = 0;
+        PassPlan lsdWidths;
+        int numLsdPasses = 0;
+
+        #pragma omp parallel num_threads(workspace.numThreads) proc_bind(close) default(none) shared(arr, buffer, n, workspace, noValues, keyOffset, msdBits, msdShift, lsdWidths, numLsdPasses)
+        {
+            const int tid = omp_get_thread_num();
+            const int teamSize = omp_get_num_threads();
+            const auto [begin, end] = threadRange(n, tid, teamSize);
+            int *localHistogram = workspace.localHistogram(tid);
+
+            computeLocalMinMax(arr, begin, end, workspace.threadLocalMin[tid], workspace.threadLocalMax[tid]);
+
+            #pragma omp barrier
+
+            #pragma omp single
+            {
+                const auto [globalMin, globalMax] = reduceMinMax(workspace.threadLocalMin.get(),
+                                                                 workspace.threadLocalMax.get(), teamSize);
+                int numBits;
+                if constexpr (KEY_RANGE) {
+                    keyOffset = globalMin;
+                    numBits = computeNumBits(globalMax - globalMin);
+                } else {
+                    numBits = computeNumBits(globalMin ^ globalMax);
+                }
+                msdBits = planMsdBits(n, numBits);
+                msdShift = numBits - msdBits;
+                numLsdPasses = msdShift > 0 ? planPasses(msdShift, n, teamSize, lsdWidths) : 0;
+            }
+
+            const int msdMask = (1 << msdBits) - 1;
+            computeLocalHistograms(arr, begin, end, localHistogram, msdShift, msdMask, keyOffset);
+
+            #pragma omp barrier
+
+            #pragma omp single
+            {
+                computeGlobalHistogram(workspace.localHistograms.get(), workspace.globalHistogram.get(), teamSize);
+                computePrefixSums(workspace.globalHistogram.get(), workspace.prefixSums.get());
+                computeThreadOffsets(workspace.localHistograms.get(), workspace.prefixSums.get(),
+                                     workspace.threadOffsets.get(), teamSize);
+            }
+
+            const ThreadScratch<void> scratch = workspace.threadScratch(tid, teamSize);
+            scatterToBuffer<false, true, true>(arr, noValues, n, begin, end, buffer, noValues, scratch, msdShift,
+                                               msdMask, msdShift, msdMask, keyOffset, false);
+
+            #pragma omp barrier
+
+            #pragma omp for schedule(dynamic, 1)
+            for (int bucket = 0; bucket <= msdMask; ++bucket) {
+                const int bucketBegin = workspace.prefixSums[bucket];
+                const int bucketEnd = bucketBegin + workspace.globalHistogram[bucket];
+                if (bucketBegin < bucketEnd) {
+                    sortBucketLsd(buffer, arr, bucketBegin, bucketEnd, lsdWidths, numLsdPasses, keyOffset,
+                                  localHistogram, scratch);
+                }
+            }
+        }
+
+        RadixSortStats stats;
+        stats.passesScattered = 1 + numLsdPasses;
+        stats.numPlannedPasses = 1 + numLsdPasses;
+        std::copy_n(lsdWidths.begin(), numLsdPasses, stats.passWidths.begin());
+        stats.passWidths[numLsdPasses] = msdBits;
+        lastRadixSortStats = stats;
+
+        return numLsdPasses % 2 == 0 ? buffer : arr;
+    }
+
+    // HybridMsdLsd: the narrowest top digit, up to DigitBits and numBits, that cuts n keys into buckets whose keys and
+    // LSD scratch fit in L2 together; larger inputs get 2^DigitBits buckets that spill into the outer caches
+    static int planMsdBits(const int n, const int numBits) {
+        const long bucketSize = std::max<long>(hostCacheSizes().l2 / static_cast<long>(2 * sizeof(Key)), 1);
+        int msdBits = 1;
+        while (msdBits < std::min(DigitBits, numBits) && (n >> msdBits) > bucketSize) {
+            ++msdBits;
+        }
+        return msdBits;
+    }
+
+    // HybridMsdLsd: serial LSD sort of keys[begin, end) on the bits below the MSD digit, with the same span of
+    // scratchKeys as the ping-pong buffer and the calling thread's workspace rows as its histogram and offsets
+    static void sortBucketLsd(Key *keys, Key *scratchKeys, const int begin, const int end, const PassPlan &passWidths,
+                              const int numPasses, const Bits keyOffset, int *histogram,
+                              const ThreadScratch<void> &scratch) {
+        void *const noValues = nullptr;
+        for (int pass = 0, shift = 0; pass < numPasses; shift += passWidths[pass++]) {
+            const int digitMask = (1 << passWidths[pass]) - 1;
+            computeLocalHistograms(keys, begin, end, histogram, shift, digitMask, keyOffset);
+            computePrefixSums(histogram, scratch.offsets);
+            for (int bucket = 0; bucket <= digitMask; ++bucket) {
+                scratch.offsets[bucket] += begin;
+            }
+
+            scatterToBuffer<false, false, true>(keys, noValues, end, begin, end, scratchKeys, noValues, scratch, shift,
+                                                digitMask, shift, digitMask, keyOffset, false);
+            std::swap(keys, scratchKeys);
+        }
+    }
+
+    // LowCardinality: Fibonacci hashing of the key bits onto a table of tableSize slots (a power of two)
+    static int distinctSlot(const Key key, const int tableSize) {
+        const uint64_t hash = static_cast<uint64_t>(RadixKeyTraits<Key>::toBits(key)) * 0x9e3779b97f4a7c15ull;
+        return static_cast<int>(hash >> (64 - std::countr_zero(static_cast<unsigned>(tableSize))));
+    }
+
+    // LowCardinality: adds one occurrence of key to the table, returns false if the key is new and the table already
+    // holds maxDistinct keys
+    static bool countDistinct(Key *tableKeys, int *tableCounts, const int tableSize, const Key key, int &numDistinct,
+                              const int maxDistinct) {
+        const Bits bits = RadixKeyTraits<Key>::toBits(key);
+        for (int slot = distinctSlot(key, tableSize);; slot = (slot + 1) & (tableSize - 1)) {
+            if (tableCounts[slot] == 0) {
+                if (numDistinct == maxDistinct) {
+                    return false;
+                }
+                ++numDistinct;
+                tableKeys[slot] = key;
+                tableCounts[slot] = 1;
+                return true;
+            }
+            if (RadixKeyTraits<Key>::toBits(tableKeys[slot]) == bits) {
+                ++tableCounts[slot];
+                return true;
+            }
+        }
+    }
+
+    // LowCardinality: whether CARDINALITY_SAMPLE_SIZE evenly spaced keys hold at most MAX_DISTINCT / 2 distinct ones
+    static bool hasFewDistinctKeys(const Key *arr, const int n) {
+        Key tableKeys[DISTINCT_TABLE_SIZE];
+        int tableCounts[DISTINCT_TABLE_SIZE] = {};
+        int numDistinct = 0;
+
+        const long stride = n / CARDINALITY_SAMPLE_SIZE;
+        for (long i = 0; i < CARDINALITY_SAMPLE_SIZE; ++i) {
+            if (!countDistinct(tableKeys, tableCounts, DISTINCT_TABLE_SIZE, arr[i * stride], numDistinct,
+                               MAX_DISTINCT / 2)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // LowCardinality: counts every key in the threads' tables, merges the tables in key order and rewrites arr as
+    // runs of equal keys, each thread filling its share of the positions; returns false, leaving arr as it was, if
+    // some thread found more than MAX_DISTINCT distinct keys
+    static bool countingSort(Key *arr, const int n, const Workspace<void> &workspace) {
+        bool overflow = false;
+        int numMerged = 0;
+
+        #pragma omp parallel num_threads(workspace.numThreads) proc_bind(close) default(none) shared(arr, n, workspace, overflow, numMerged)
+        {
+            const int tid = omp_get_thread_num();
+            const int teamSize = omp_get_num_threads();
+            const auto [begin, end] = threadRange(n, tid, teamSize);
+            Key *tableKeys = &workspace.distinctKeys[tid * DISTINCT_TABLE_SIZE];
+            int *tableCounts = &workspace.distinctCounts[tid * DISTINCT_TABLE_SIZE];
+            std::fill_n(tableCounts, DISTINCT_TABLE_SIZE, 0);
+
+            int numDistinct = 0;
+            for (int i = begin; i < end; ++i) {
+                if (!countDistinct(tableKeys, tableCounts, DISTINCT_TABLE_SIZE, arr[i], numDistinct, MAX_DISTINCT)) {
+                    #pragma omp atomic write
+                    overflow = true;
+                    break;
+                }
+            }
+
+            #pragma omp barrier
+
+            #pragma omp single
+            if (!overflow) {
+                numMerged = mergeDistinctKeys(workspace, teamSize);
+            }
+
+            if (!overflow) {
+                fillRuns(arr, n, workspace.mergedDistinct.get(), numMerged, tid, teamSize);
+            }
+        }
+
+        if (!overflow) {
+            RadixSortStats stats;
+            stats.numDistinct = numMerged;
+            lastRadixSortStats = stats;
+        }
+        return !overflow;
+    }
+
+    // LowCardinality: gathers the threads' table entries, sorts them by key, folds equal keys together, and turns
+    // the counts into the position each key's run starts at; returns the number of distinct keys
+    static int mergeDistinctKeys(const Workspace<void> &workspace, const int numThreads) {
+        DistinctKey *merged = workspace.mergedDistinct.get();
+        int numMerged = 0;
+        for (int slot = 0; slot < numThreads * DISTINCT_TABLE_SIZE; ++slot) {
+            if (workspace.distinctCounts[slot] > 0) {
+                merged[numMerged++] = {workspace.distinctKeys[slot], workspace.distinctCounts[slot]};
+            }
+        }
+
+        std::sort(merged, merged + numMerged, [](const DistinctKey &a, const DistinctKey &b) {
+            return RadixKeyTraits<Key>::toBits(a.key) < RadixKeyTraits<Key>::toBits(b.key);
+        });
+
+        int numDistinct = 0;
+        for (int i = 0; i < numMerged; ++i) {
+            if (numDistinct > 0 && RadixKeyTraits<Key>::toBits(merged[numDistinct - 1].key) ==
+                                   RadixKeyTraits<Key>::toBits(merged[i].key)) {
+                merged[numDistinct - 1].count += merged[i].count;
+            } else {
+                merged[numDistinct++] = merged[i];
+            }
+        }
+
+        int runStart = 0;
+        for (int i = 0; i < numDistinct; ++i) {
+            const int count = merged[i].count;
+            merged[i].count = runStart;
+            runStart += count;
+        }
+        return numDistinct;
+    }
+
+    // LowCardinality: writes the thread's share of [0, n) of the runs, whose start positions are in runs[].count
+    static void fillRuns(Key *arr, const int n, const DistinctKey *runs, const int numRuns, const int tid,
+                         const int teamSize) {
+        const auto [begin, end] = threadRange(n, tid, teamSize);
+        // the last run that starts at or before begin
+        int run = static_cast<int>(std::upper_bound(runs, runs + numRuns, begin, [](const int position,
+                                                                                     const DistinctKey &r) {
+            return position < r.count;
+        }) - runs) - 1;
+
+        for (int i = begin; i < end; ++run) {
+            const int runEnd = std::min(end, run + 1 < numRuns ? runs[run + 1].count : n);
+            std::fill(arr + i, arr + runEnd, runs[run].key);
+            i = runEnd;
+        }
+    }
+
+    // the contiguous block of [0, n) a thread reads in every pass; the scatter relies on it to tell which thread
+    // reads a position in the next pass
+    static std::pair<int, int> threadRange(const int n, const int tid, const int teamSize) {
+        const int chunkSize = (n + teamSize - 1) / teamSize;
+        const int begin = std::min(n, tid * chunkSize);
+        return {begin, std::min(n, begin + chunkSize)};
+    }
+
+    static int digitOf(const Key key, const int shift, const int digitMask, const Bits keyOffset) {
+        Bits bits = RadixKeyTraits<Key>::toBits(key);
+        if constexpr (KEY_RANGE) {
+            bits -= keyOffset;
+        }
+        return static_cast<int>((bits >> shift) & digitMask);
+    }
+
+    // the buffers of an empty input may be null, which memcpy must not be given even for zero bytes
+    template<typename T>
+    static void parallelCopy(T *destination, const T *source, const int n, const int numThreads) {
+        if (n == 0) {
+            return;
+        }
+
+        #pragma omp parallel num_threads(numThreads) default(none) shared(destination, source, n)
+        {
+            const int numChunks = omp_get_num_threads();
+            const int chunkSize = (n + numChunks - 1) / numChunks;
+            const int begin = std::min(n, omp_get_thread_num() * chunkSize);
+            const int end = std::min(n, begin + chunkSize);
+            if (end > begin) {
+                std::memcpy(destination + begin, source + begin, (end - begin) * sizeof(T));
+            }
+        }
+    }
+
+    // 32-bit integer keys with digits of up to 11 bits go through the vectorized digitCountKernel, whose
+    // DIGIT_COUNT_COPIES histograms live on the stack, when the range is long enough to pay for summing them
+    static void computeLocalHistograms(const Key *__restrict arr, const int begin, const int end,
+                                       int *__restrict localHistogram, const int shift, const int digitMask,
+                                       const Bits keyOffset) {
+        std::memset(localHistogram, 0, NUM_BUCKETS * sizeof(int));
+
+        if constexpr (std::is_integral_v<Key> && sizeof(Key) == sizeof(uint32_t) && DigitBits <= 11) {
+            if (end - begin >= DIGIT_COUNT_COPIES * NUM_BUCKETS) {
+                alignas(CACHE_LINE_SIZE) int counts[DIGIT_COUNT_COPIES * NUM_BUCKETS];
+                std::memset(counts, 0, sizeof(counts));
+                digitCountKernel()(reinterpret_cast<const uint32_t *>(arr + begin), end - begin, counts, NUM_BUCKETS,
+                                   RadixKeyTraits<Key>::SIGN_FLIP, KEY_RANGE ? keyOffset : 0, shift, digitMask);
+                for (int copy = 0; copy < DIGIT_COUNT_COPIES; ++copy) {
+                    for (int bucket = 0; bucket <= digitMask; ++bucket) {
+                        localHistogram[bucket] += counts[copy * NUM_BUCKETS + bucket];
+                    }
+                }
+                return;
+            }
+        }
+
+        for (int i = begin; i < end; ++i) {
+            localHistogram[digitOf(arr[i], shift, digitMask, keyOffset)]++;
+        }
+    }
+
+    // COUNT_RUNS (PresortedRuns): also counts the ascents and descents from each key's predecessor, the first key of
+    // the range compared with the last key of the previous one
+    template<bool COUNT_RUNS>
+    static void computeLocalHistogramsWithMinMax(const Key *__restrict arr, const int begin, const int end,
+                                                 int *__restrict localHistogram, Bits &threadLocalMin,
+                                                 Bits &threadLocalMax, int *ascents = nullptr,
+                                                 int *descents = nullptr) {
+        std::memset(localHistogram, 0, NUM_BUCKETS * sizeof(int));
+        Bits localMin = std::numeric_limits<Bits>::max();
+        Bits localMax = 0;
+        int localAscents = 0;
+        int localDescents = 0;
+
+        for (int i = begin; i < end; ++i) {
+            const Bits bits = RadixKeyTraits<Key>::toBits(arr[i]);
+            localMin = std::min(localMin, bits);
+            localMax = std::max(localMax, bits);
+            localHistogram[bits & (NUM_BUCKETS - 1)]++;
+
+            if constexpr (COUNT_RUNS) {
+                const Bits previous = RadixKeyTraits<Key>::toBits(arr[std::max(i - 1, 0)]);
+                localAscents += bits > previous;
+                localDescents += bits < previous;
+            }
+        }
+
+        threadLocalMin = localMin;
+        threadLocalMax = localMax;
+        if constexpr (COUNT_RUNS) {
+            *ascents = localAscents;
+            *descents = localDescents;
+        }
+    }
+
+    // PresortedRuns: the positions of the descents in [begin, end) that the first read counted
+    static void findLocalRunStarts(const Key *__restrict arr, const int begin, const int end, int *runStarts) {
+        int numFound = 0;
+        for (int i = std::max(begin, 1); i < end; ++i) {
+            if (RadixKeyTraits<Key>::toBits(arr[i]) < RadixKeyTraits<Key>::toBits(arr[i - 1])) {
+                runStarts[numFound++] = i;
+            }
+        }
+    }
+
+    static void computeLocalMinMax(const Key *__restrict arr, const int begin, const int end, Bits &threadLocalMin,
+                                   Bits &threadLocalMax) {
+        Bits localMin = std::numeric_limits<Bits>::max();
+        Bits localMax = 0;
+
+        for (int i = begin; i < end; ++i) {
+            const Bits bits = RadixKeyTraits<Key>::toBits(arr[i]);
+            localMin = std::min(localMin, bits);
+            localMax = std::max(localMax, bits);
+        }
+
+        threadLocalMin = localMin;
+        threadLocalMax = localMax;
+    }
+
+    // FusedHistograms: one read counts every digit (MAX_PASSES rows) and tracks the min and max bits
+    static void computeLocalDigitHistograms(const Key *__restrict arr, const int begin, const int end,
+                                            int *__restrict digitHistograms, Bits &threadLocalMin,
+                                            Bits &threadLocalMax) {
+        std::memset(digitHistograms, 0, MAX_PASSES * THREAD_STRIDE * sizeof(int));
+        Bits localMin = std::numeric_limits<Bits>::max();
+        Bits localMax = 0;
+
+        for (int i = begin; i < end; ++i) {
+            const Bits bits = RadixKeyTraits<Key>::toBits(arr[i]);
+            localMin = std::min(localMin, bits);
+            localMax = std::max(localMax, bits);
+            for (int digit = 0; digit < MAX_PASSES; ++digit) {
+                digitHistograms[digit * THREAD_STRIDE + ((bits >> (digit * DigitBits)) & (NUM_BUCKETS - 1))]++;
+            }
+        }
+
+        threadLocalMin = localMin;
+        threadLocalMax = localMax;
+    }
+
+    static void computeDigitGlobalHistograms(const int *digitHistograms, int *digitGlobalHistograms,
+                                             const int numThreads) {
+        std::memset(digitGlobalHistograms, 0, MAX_PASSES * NUM_BUCKETS * sizeof(int));
+        for (int t = 0; t < numThreads; ++t) {
+            for (int digit = 0; digit < MAX_PASSES; ++digit) {
+                const int *localHistogram = &digitHistograms[(t * MAX_PASSES + digit) * THREAD_STRIDE];
+                int *globalHistogram = &digitGlobalHistograms[digit * NUM_BUCKETS];
+                for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+                    globalHistogram[bucket] += localHistogram[bucket];
+                }
+            }
+        }
+    }
+
+    // FusedHistograms: a thread's histogram for this pass is the sum of what every writer of the previous scatter
+    // counted for it
+    static void gatherNextCounts(const int *nextCounts, int *__restrict localHistogram, const int tid,
+                                 const int teamSize) {
+        std::memset(localHistogram, 0, NUM_BUCKETS * sizeof(int));
+        for (int writer = 0; writer < teamSize; ++writer) {
+            const int *counts = &nextCounts[(writer * teamSize + tid) * THREAD_STRIDE];
+            for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+                localHistogram[bucket] += counts[bucket];
+            }
+        }
+    }
+
+    static std::pair<Bits, Bits> reduceMinMax(const Bits *threadLocalMin, const Bits *threadLocalMax,
+                                              const int numThreads) {
+        Bits globalMin = threadLocalMin[0];
+        Bits globalMax = threadLocalMax[0];
+        for (int t = 1; t < numThreads; ++t) {
+            globalMin = std::min(globalMin, threadLocalMin[t]);
+            globalMax = std::max(globalMax, threadLocalMax[t]);
+        }
+        return {globalMin, globalMax};
+    }
+
+    // number of low bits that can differ between keys, given the min ^ max or max - min of the input
+    static int computeNumBits(const Bits significantBits) {
+        return std::max(static_cast<int>(std::bit_width(significantBits)), DigitBits);
+    }
+
+    // splits numBits into the fewest passes of at most maxDigitBits and spreads the bits evenly over them, so that
+    // no pass sorts a wider digit than it needs (20 bits at 8 per pass: 7 + 7 + 6 instead of 8 + 8 + 4); returns the
+    // number of passes. FusedHistograms counted every digit at its DigitBits-aligned position up front and keeps the
+    // fixed split.
+    static int planPasses(const int numBits, const int n, const int numThreads, PassPlan &passWidths) {
+        const int maxDigitBits = ADAPTIVE_DIGIT_WIDTH ? planMaxDigitBits(n, numThreads) : DigitBits;
+        const int numPasses = (numBits + maxDigitBits - 1) / maxDigitBits;
+        for (int pass = 0; pass < KEY_BITS; ++pass) {
+            passWidths[pass] = FUSED_HISTOGRAMS ? DigitBits : numBits / numPasses + (pass < numBits % numPasses);
+        }
+        return numPasses;
+    }
+
+    // AdaptiveDigitWidth: the widest digit up to DigitBits for which a thread's histogram and offsets rows fit in L1,
+    // its staging area (or one destination line per bucket when scattering directly) fits in L2, and its chunk of
+    // the input holds at least one key per bucket
+    static int planMaxDigitBits(const int n, const int numThreads) {
+        const CacheSizes &cache = hostCacheSizes();
+        const long chunkSize = std::max(1, n / numThreads);
+        const long countBytesPerBucket = 2 * sizeof(int);
+        const long scatterBytesPerBucket = std::max<long>(WriteBufferSize * sizeof(Key), 64);
+
+        int digitBits = DigitBits;
+        while (digitBits > 1) {
+            const long buckets = 1L << digitBits;
+            if (buckets * countBytesPerBucket <= cache.l1 && buckets * scatterBytesPerBucket <= cache.l2 &&
+                buckets <= chunkSize) {
+                break;
+            }
+            --digitBits;
+        }
+        return digitBits;
+    }
+
+    // the first histogram was counted on raw digits before the min was known; the lowest digit of (key - min) is
+    // the raw digit minus the lowest digit of min (mod NUM_BUCKETS), so a rotation rebases the counts
+    static void rebaseLocalHistograms(int *localHistograms, const Bits globalMin, const int numThreads) {
+        const int rotation = static_cast<int>(globalMin & (NUM_BUCKETS - 1));
+        for (int t = 0; t < numThreads; ++t) {
+            int *localHistogram = &localHistograms[t * THREAD_STRIDE];
+            std::rotate(localHistogram, localHistogram + rotation, localHistogram + NUM_BUCKETS);
+        }
+    }
+
+    // the first histogram is counted DigitBits wide before the plan is known; the digit of a narrower first pass is
+    // the low bits of the counted one, so the upper buckets fold onto it
+    static void foldLocalHistograms(int *localHistograms, const int digitBits, const int numThreads) {
+        const int digitMask = (1 << digitBits) - 1;
+        for (int t = 0; t < numThreads; ++t) {
+            int *localHistogram = &localHistograms[t * THREAD_STRIDE];
+            for (int bucket = digitMask + 1; bucket < NUM_BUCKETS; ++bucket) {
+                localHistogram[bucket & digitMask] += localHistogram[bucket];
+                localHistogram[bucket] = 0;
+            }
+        }
+    }
+
+    // PresortedRuns: sums the first read's ascents and descents into the input order. A few runs are only worth
+    // merging when their merge rounds cost less than the planned radix passes; a round reads and writes every key
+    // sequentially but its data-dependent selects make it about 1.5 times as slow as a pass. Only the teamSize threads
+    // OpenMP granted wrote their counts, which may be fewer than the workspace has rows for.
+    static InputOrder classifyInputOrder(const Workspace<void> &workspace, const int teamSize, const int numPasses,
+                                         int &numRuns) {
+        int ascents = 0;
+        int descents = 0;
+        for (int t = 0; t < teamSize; ++t) {
+            ascents += workspace.threadAscents[t];
+            descents += workspace.threadDescents[t];
+        }
+
+        numRuns = descents + 1;
+        if (descents == 0) {
+            return InputOrder::SORTED;
+        }
+        if (ascents == 0) {
+            return InputOrder::REVERSED;
+        }
+        const int mergeRounds = std::bit_width(static_cast<unsigned>(numRuns - 1));
+        if (numRuns > MAX_MERGED_RUNS || 3 * mergeRounds >= 2 * numPasses) {
+            return InputOrder::UNSORTED;
+        }
+        return InputOrder::FEW_RUNS;
+    }
+
+    // PresortedRuns: fills workspace.runStarts with 0, the team's descent positions in order, and n
+    static void gatherRunStarts(const Workspace<void> &workspace, const int n, const int teamSize) {
+        int run = 0;
+        workspace.runStarts[run++] = 0;
+        for (int t = 0; t < teamSize; ++t) {
+            for (int descent = 0; descent < workspace.threadDescents[t]; ++descent) {
+                workspace.runStarts[run++] = workspace.threadRunStarts[t * MAX_MERGED_RUNS + descent];
+            }
+        }
+        workspace.runStarts[run] = n;
+    }
+
+    // PresortedRuns: the thread's share of the swaps that reverse arr
+    static void reverseInPlace(Key *arr, const int n, const int tid, const int teamSize) {
+        const auto [begin, end] = threadRange(n / 2, tid, teamSize);
+        for (int i = begin; i < end; ++i) {
+            std::swap(arr[i], arr[n - 1 - i]);
+        }
+    }
+
+    // PresortedRuns: merges runs 2r and 2r + 1 of source into the same span of destination for every r (an odd last
+    // run is copied); each thread writes its share of every merged span, found by a co-rank search
+    static void mergeRunPairs(const Key *source, Key *destination, const int *runStarts, const int numRuns,
+                              const int tid, const int teamSize) {
+        for (int run = 0; run < numRuns; run += 2) {
+            const int leftBegin = runStarts[run];
+            const int rightBegin = runStarts[std::min(run + 1, numRuns)];
+            const int rightEnd = runStarts[std::min(run + 2, numRuns)];
+            const Key *left = source + leftBegin;
+            const Key *right = source + rightBegin;
+            const int leftSize = rightBegin - leftBegin;
+            const int rightSize = rightEnd - rightBegin;
+
+            const auto [outBegin, outEnd] = threadRange(leftSize + rightSize, tid, teamSize);
+            int i = mergeCoRank(left, leftSize, right, rightSize, outBegin);
+            int j = outBegin - i;
+            Key *out = destination + leftBegin;
+            int k = outBegin;
+            while (k < outEnd && i < leftSize && j < rightSize) {
+                // every step takes one key, so this many steps cannot run past either run or the share
+                const int safeSteps = std::min({outEnd - k, leftSize - i, rightSize - j});
+                for (const int stop = k + safeSteps; k < stop; ++k) {
+                    // branch-free; ties take the left run first, which keeps the merge stable
+                    const Key leftKey = left[i];
+                    const Key rightKey = right[j];
+                    const bool takeRight = RadixKeyTraits<Key>::toBits(rightKey) <
+                                           RadixKeyTraits<Key>::toBits(leftKey);
+                    out[k] = takeRight ? rightKey : leftKey;
+                    i += !takeRight;
+                    j += takeRight;
+                }
+            }
+
+            // one run is used up, the rest of the share comes from the other
+            const Key *rest = i < leftSize ? left + i : right + j;
+            std::memcpy(out + k, rest, (outEnd - k) * sizeof(Key));
+        }
+    }
+
+    // how many of the first k keys of the stable merge of left and right come from left
+    static int mergeCoRank(const Key *left, const int leftSize, const Key *right, const int rightSize, const int k) {
+        int low = std::max(0, k - rightSize);
+        int high = std::min(k, leftSize);
+        while (true) {
+            const int i = low + (high - low) / 2;
+            const int j = k - i;
+            if (i > 0 && j < rightSize &&
+                RadixKeyTraits<Key>::toBits(left[i - 1]) > RadixKeyTraits<Key>::toBits(right[j])) {
+                high = i - 1;
+            } else if (j > 0 && i < leftSize &&
+                       RadixKeyTraits<Key>::toBits(right[j - 1]) >= RadixKeyTraits<Key>::toBits(left[i])) {
+                low = i + 1;
+            } else {
+                return i;
+            }
+        }
+    }
+
+    // PresortedRuns: the run starts after a merge round, every second one followed by n
+    static void halveRunStarts(int *runStarts, const int numRuns) {
+        const int merged = (numRuns + 1) / 2;
+        for (int run = 1; run <= merged; ++run) {
+            runStarts[run] = runStarts[std::min(2 * run, numRuns)];
+        }
+    }
+
+    // a pass is trivial when every key falls into one bucket, which then holds all n of them
+    static bool isTrivialHistogram(const int *globalHistogram, const int n) {
+        return std::find(globalHistogram, globalHistogram + NUM_BUCKETS, n) != globalHistogram + NUM_BUCKETS;
+    }
+
+    static void computeGlobalHistogram(const int *localHistograms, int *globalHistogram, const int numThreads) {
+        std::memset(globalHistogram, 0, NUM_BUCKETS * sizeof(int));
+        for (int t = 0; t < numThreads; ++t) {
+            const int *localHistogram = &localHistograms[t * THREAD_STRIDE];
+            for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+                globalHistogram[bucket] += localHistogram[bucket];
+            }
+        }
+    }
+
+    static void computePrefixSums(const int *globalHistogram, int *prefixSums) {
+        int sum = 0;
+        for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+            prefixSums[bucket] = sum;
+            sum += globalHistogram[bucket];
+        }
+    }
+
+    static void computeThreadOffsets(const int *localHistograms, const int *prefixSums, int *threadOffsets,
+                                     const int numThreads) {
+        std::memcpy(threadOffsets, prefixSums, NUM_BUCKETS * sizeof(int));
+        for (int t = 1; t < numThreads; ++t) {
+            const int *previousOffsets = &threadOffsets[(t - 1) * THREAD_STRIDE];
+            const int *previousHistogram = &localHistograms[(t - 1) * THREAD_STRIDE];
+            int *offsets = &threadOffsets[t * THREAD_STRIDE];
+            for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+                offsets[bucket] = previousOffsets[bucket] + previousHistogram[bucket];
+            }
+        }
+    }
+
+    // ARGSORT && FIRST_PASS: the value of arr[i] is i itself and values is not read
+    // ARGSORT && LAST_PASS:  only the values are written, buffer is not touched
+    // FusedHistograms, NextPassHistograms: every pass but the last counts the digit at nextShift (nextDigitMask wide)
+    //                        of each key it writes into scratch.nextCounts, split by the thread that reads that
+    //                        position in the next pass
+    // streamStores:          (StreamingStores, keys only) the staged keys go out as whole destination cache lines
+    //                        with non-temporal stores, see flushStaged
+    // scratch.prefetchDistance > 0: without staging, the key that many positions ahead is read and the line its
+    //                        bucket writes next is prefetched; with staging, the lines of a bucket's next flush are
+    //                        prefetched when that many keys remain until it (not for streamed stores, which bypass
+    //                        the caches). The staged kernel reads its input sequentially, which the hardware
+    //                        prefetchers already cover.
+    template<bool ARGSORT, bool FIRST_PASS, bool LAST_PASS, typename Value>
+    static void scatterToBuffer(const Key *__restrict arr, const Value *__restrict values, const int n, const int begin,
+                                const int end, Key *__restrict buffer, Value *__restrict valueBuffer,
+                                const ThreadScratch<Value> &scratch, const int shift, const int digitMask,
+                                const int nextShift, const int nextDigitMask, const Bits keyOffset,
+                                const bool streamStores) {
+        constexpr bool INDEX_VALUES = ARGSORT && FIRST_PASS;
+        constexpr bool DROP_KEYS = ARGSORT && LAST_PASS;
+        constexpr bool COUNT_NEXT = COUNT_IN_SCATTER && !LAST_PASS;
+
+        int *__restrict localOffsets = scratch.offsets;
+        const int readerChunkSize = (n + omp_get_num_threads() - 1) / omp_get_num_threads();
+        if constexpr (COUNT_NEXT) {
+            std::memset(scratch.nextCounts, 0, omp_get_num_threads() * THREAD_STRIDE * sizeof(int));
+        }
+
+        if constexpr (WriteBufferSize == 0) {
+            const int prefetchDistance = scratch.prefetchDistance;
+            const int prefetchEnd = prefetchDistance > 0 ? end - prefetchDistance : begin;
+            for (int i = begin; i < end; ++i) {
+                if (i < prefetchEnd) {
+                    const int ahead = localOffsets[digitOf(arr[i + prefetchDistance], shift, digitMask, keyOffset)];
+                    prefetchDestination<DROP_KEYS>(buffer, valueBuffer, ahead, 1);
+                }
+
+                const Key key = arr[i];
+                const int pos = localOffsets[digitOf(key, shift, digitMask, keyOffset)]++;
+                if constexpr (!DROP_KEYS) {
+                    buffer[pos] = key;
+                }
+                if constexpr (!std::is_void_v<Value>) {
+                    valueBuffer[pos] = valueAt<INDEX_VALUES>(values, i);
+                }
+                if constexpr (COUNT_NEXT) {
+                    const int reader = pos / readerChunkSize;
+                    scratch.nextCounts[reader * THREAD_STRIDE + digitOf(key, nextShift, nextDigitMask, keyOffset)]++;
+                }
+            }
+        } else {
+            // software write-combining: stage WriteBufferSize keys (and their values) per bucket and flush them with
+            // one memcpy per array
+            Key *__restrict stagedKeys = scratch.stagedKeys;
+            ValueSlot<Value> *__restrict stagedValues = scratch.stagedValues;
+            int *__restrict stagedCounts = scratch.stagedCounts;
+            std::memset(stagedCounts, 0, NUM_BUCKETS * sizeof(int));
+            // the staged count at which a bucket's next flush is prefetched, never reached when not prefetching
+            const int prefetchAt = scratch.prefetchDistance > 0 && !streamStores
+                                       ? std::max(WriteBufferSize - scratch.prefetchDistance, 1)
+                                       : WriteBufferSize + 1;
+
+            for (int i = begin; i < end; ++i) {
+                const Key key = arr[i];
+                const int bucket = digitOf(key, shift, digitMask, keyOffset);
+                const int staged = bucket * WriteBufferSize + stagedCounts[bucket]++;
+
+                if constexpr (!DROP_KEYS) {
+                    stagedKeys[staged] = key;
+                }
+                if constexpr (!std::is_void_v<Value>) {
+                    stagedValues[staged] = valueAt<INDEX_VALUES>(values, i);
+                }
+
+                if (stagedCounts[bucket] == prefetchAt) {
+                    prefetchDestination<DROP_KEYS>(buffer, valueBuffer, localOffsets[bucket], WriteBufferSize);
+                }
+                if (stagedCounts[bucket] == WriteBufferSize) {
+                    stagedCounts[bucket] = flushStaged<DROP_KEYS, COUNT_NEXT>(
+                        buffer, valueBuffer, scratch, bucket, WriteBufferSize, readerChunkSize, nextShift,
+                        nextDigitMask, keyOffset, streamStores, false);
+                }
+            }
+
+            for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+                if (stagedCounts[bucket] > 0) {
+                    flushStaged<DROP_KEYS, COUNT_NEXT>(buffer, valueBuffer, scratch, bucket, stagedCounts[bucket],
+                                                       readerChunkSize, nextShift, nextDigitMask, keyOffset,
+                                                       streamStores, true);
+                }
+            }
+
+            // the non-temporal stores are weakly ordered, drain them before the barrier hands buffer to the readers
+#if defined(__SSE2__)
+            if (STREAMING_STORES && streamStores) {
+                _mm_sfence();
+            }
+#endif
+        }
+    }
+
+    // prefetches for writing the lines that count keys (and values) from position pos on will be stored to
+    template<bool DROP_KEYS, typename Value>
+    static void prefetchDestination(Key *buffer, Value *valueBuffer, const int pos, const int count) {
+        if constexpr (!DROP_KEYS) {
+            const auto *first = reinterpret_cast<const char *>(&buffer[pos]);
+            for (std::size_t line = 0; line < count * sizeof(Key); line += CACHE_LINE_SIZE) {
+                __builtin_prefetch(first + line, 1);
+            }
+        }
+        if constexpr (!std::is_void_v<Value>) {
+            const auto *first = reinterpret_cast<const char *>(&valueBuffer[pos]);
+            for (std::size_t line = 0; line < count * sizeof(Value); line += CACHE_LINE_SIZE) {
+                __builtin_prefetch(first + line, 1);
+            }
+        }
+    }
+
+    template<bool INDEX_VALUES, typename Value>
+    static Value valueAt(const Value *values, const int i) {
+        if constexpr (INDEX_VALUES) {
+            return static_cast<Value>(i);
+        } else {
+            return values[i];
+        }
+    }
+
+    // writes the first count staged keys (and values) of the bucket to its next positions and returns how many stay
+    // staged. streamStores: the keys up to the destination's next cache-line boundary are copied, the whole lines
+    // after it are streamed, and a partial last line stays staged (moved to the front) unless this is the final
+    // flush, so that once a bucket's offset is aligned every later flush is whole lines only
+    template<bool DROP_KEYS, bool COUNT_NEXT, typename Value>
+    static int flushStaged(Key *__restrict buffer, Value *__restrict valueBuffer, const ThreadScratch<Value> &scratch,
+                           const int bucket, const int count, const int readerChunkSize, const int nextShift,
+                           const int nextDigitMask, const Bits keyOffset, const bool streamStores,
+                           const bool finalFlush) {
+        const int staged = bucket * WriteBufferSize;
+        const int offset = scratch.offsets[bucket];
+        int flushCount = count;
+        if constexpr (!DROP_KEYS) {
+            if (STREAMING_STORES && streamStores) {
+                flushCount = streamToLines(&buffer[offset], &scratch.stagedKeys[staged], count, finalFlush);
+            } else {
+                std::memcpy(&buffer[offset], &scratch.stagedKeys[staged], count * sizeof(Key));
+            }
+        }
+        if constexpr (!std::is_void_v<Value>) {
+            std::memcpy(&valueBuffer[offset], &scratch.stagedValues[staged], flushCount * sizeof(Value));
+        }
+        scratch.offsets[bucket] += flushCount;
+
+        // the staged keys land on consecutive positions, so the reading thread only changes at chunk boundaries
+        if constexpr (COUNT_NEXT) {
+            const Key *stagedKeys = &scratch.stagedKeys[staged];
+            for (int reader = offset / readerChunkSize, j = 0; j < flushCount; ++reader) {
+                int *__restrict counts = &scratch.nextCounts[reader * THREAD_STRIDE];
+                const int readerEnd = std::min(flushCount, (reader + 1) * readerChunkSize - offset);
+                for (; j < readerEnd; ++j) {
+                    ++counts[digitOf(stagedKeys[j], nextShift, nextDigitMask, keyOffset)];
+                }
+            }
+        }
+
+        const int keptCount = count - flushCount;
+        if (keptCount > 0) {
+            std::memmove(&scratch.stagedKeys[staged], &scratch.stagedKeys[staged + flushCount],
+                         keptCount * sizeof(Key));
+        }
+        return keptCount;
+    }
+
+    // StreamingStores: copies keys to dst up to its next cache-line boundary, streams the whole lines after it with
+    // non-temporal stores (the widest the running CPU has) and copies a partial last line only when flushTail is set;
+    // returns the number of keys written
+    static int streamToLines(Key *dst, const Key *src, const int count, const bool flushTail) {
+        constexpr int KEYS_PER_LINE = CACHE_LINE_SIZE / sizeof(Key);
+        const auto misalignment = reinterpret_cast<std::uintptr_t>(dst) % CACHE_LINE_SIZE;
+        const int headCount = std::min(count, static_cast<int>((CACHE_LINE_SIZE - misalignment) % CACHE_LINE_SIZE /
+                                                               sizeof(Key)));
+        const int lineCount = (count - headCount) / KEYS_PER_LINE;
+        const int written = headCount + lineCount * KEYS_PER_LINE;
+
+        std::memcpy(dst, src, headCount * sizeof(Key));
+        if (lineCount > 0) {
+#if defined(__SSE2__)
+            streamLinesKernel()(dst + headCount, src + headCount, lineCount);
+#else
+            std::memcpy(dst + headCount, src + headCount, lineCount * CACHE_LINE_SIZE);
+#endif
+        }
+        if (flushTail) {
+            std::memcpy(dst + written, src + written, (count - written) * sizeof(Key));
+            return count;
+        }
+        return written;
+    }
+};
+
+// preallocated state for repeated sorts with one RadixSorter on a fixed number of threads: the engine's workspace and
+// a ping-pong buffer of capacity keys are allocated once, the buffer on huge pages and prefaulted by the context's
+// threads, and every sort runs its passes in a single parallel region on OpenMP's persistent team, bound to cores with
+// proc_bind(close), so sorting allocates nothing, faults in no pages and starts no threads unless n outgrows the
+// capacity
+template<typename Sorter>
+class RadixSortContext {
+public:
+    using Key = typename Sorter::KeyType;
+
+    RadixSortContext(const int capacity, const int numThreads)
+        : workspace(numThreads), buffer(makeHugePageArray<Key>(capacity, numThreads)), bufferCapacity(capacity) {}
+
+    // sorts arr in place
+    void sort(Key *arr, const int n) {
+        sort(arr, n, workspace.maxThreads);
+    }
+
+    // sorts arr in place on the first numThreads of the context's threads, for inputs too small to keep all of them
+    // busy; the workspace and buffer are shared with the full-width sorts
+    void sort(Key *arr, const int n, const int numThreads) {
+        reserve(n);
+        workspace.numThreads = std::clamp(numThreads, 1, workspace.maxThreads);
+        const Key *result = Sorter::sortPairBuffers(arr, buffer.get(), static_cast<void *>(nullptr),
+                                                    static_cast<void *>(nullptr), n, workspace);
+        if (result != arr) {
+            Sorter::parallelCopy(arr, result, n, workspace.numThreads);
+        }
+    }
+
+    void reserve(const int capacity) {
+        if (capacity > bufferCapacity) {
+            buffer = makeHugePageArray<Key>(capacity, workspace.maxThreads);
+            bufferCapacity = capacity;
+        }
+    }
+
+    int numThreads() const {
+        return workspace.maxThreads;
+    }
+
+    // software prefetch distance of the scatters in keys, 0 (the default) for none; worth trying with wide digits,
+    // whose scattered destinations the hardware prefetchers cannot follow
+    void setPrefetchDistance(const int distance) {
+        workspace.prefetchDistance = distance;
+    }
+
+    int prefetchDistance() const {
+        return workspace.prefetchDistance;
+    }
+
+private:
+    typename Sorter::template Workspace<void> workspace;
+    HugePageArray<Key> buffer;
+    int bufferCapacity;
+};
@@ -50,3 +50,63 @@ void SerialRadixSort::scatterToBuffer(const int *arr, const int n, int *buffer,
         buffer[pos] = value;
     }
 }
+
+constexpr int NUM_BYTES = sizeof(int);
+constexpr unsigned SIGN_FLIP = 1u << (sizeof(int) * 8 - 1);
+
+static int byteOf(const int key, const int shift) {
+    return static_cast<int>(((static_cast<unsigned>(key) ^ SIGN_FLIP) >> shift) & (BYTE_BUCKETS - 1));
+}
+
+void SerialByteRadixSort::sort(int *arr, const int n, int *buffer) {
+    if (n <= 1) {
+        return;
+    }
+
+    int histograms[NUM_BYTES][BYTE_BUCKETS];
+    buildHistograms(arr, n, histograms);
+
+    int *source = arr;
+    int *destination = buffer;
+    for (int byte = 0; byte < NUM_BYTES; ++byte) {
+        const int shift = byte * BYTE_BITS;
+        if (histograms[byte][byteOf(source[0], shift)] == n) {
+            continue;
+        }
+
+        int prefixSums[BYTE_BUCKETS];
+        computePrefixSums(histograms[byte], prefixSums);
+        scatterToBuffer(source, n, destination, prefixSums, shift);
+        std::swap(source, destination);
+    }
+
+    if (source != arr) {
+        std::memcpy(arr, source, n * sizeof(int));
+    }
+}
+
+void SerialByteRadixSort::buildHistograms(const int *arr, const int n, int (*histograms)[BYTE_BUCKETS]) {
+    std::memset(histograms, 0, sizeof(int) * NUM_BYTES * BYTE_BUCKETS);
+
+    for (int i = 0; i < n; i++) {
+        for (int byte = 0; byte < NUM_BYTES; byte++) {
+            histograms[byte][byteOf(arr[i], byte * BYTE_BITS)]++;
+        }
+    }
+}
+
+void SerialByteRadixSort::computePrefixSums(const int *histogram, int *prefixSums) {
+    int sum = 0;
+    for (int bucket = 0; bucket < BYTE_BUCKETS; bucket++) {
+        prefixSums[bucket] = sum;
+        sum += histogram[bucket];
+    }
+}
+
+void SerialByteRadixSort::scatterToBuffer(const int *arr, const int n, int *buffer, int *prefixSums, const int shift) {
+    for (int i = 0; i < n; i++) {
+        const int value = arr[i];
+        const int pos = prefixSums[byteOf(value, shift)]++;
+        buffer[pos] = value;
+    }
+}
@@ -14,5 +14,23 @@ private:
     static void scatterToBuffer(const int *arr, int n, int *buffer, int *prefixSums, int shift);
 };
 
+constexpr int BYTE_BITS = 8;
+constexpr int BYTE_BUCKETS = 1 << BYTE_BITS;
+
+// 8 bits per pass with signed keys in numeric order: every byte's histogram is counted in one read, and the passes
+// whose byte is the same for every key are skipped
+class SerialByteRadixSort {
+public:
+    // sorts arr in place, buffer holds at least n keys of scratch
+    static void sort(int *arr, int n, int *buffer);
+
+private:
+    static void buildHistograms(const int *arr, int n, int (*histograms)[BYTE_BUCKETS]);
+
+    static void computePrefixSums(const int *histogram, int *prefixSums);
+
+    static void scatterToBuffer(const int *arr, int n, int *buffer, int *prefixSums, int shift);
+};
+
 
 #endif //SERIAL_RADIX_SORT_H
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <vector>
+
+// seconds per sort of the first n keys of data, the best of several batches of repeated sorts so that tiny inputs
+// still time above the clock's resolution
+inline double timeSort(const std::function<void(int *, int)> &sorter, const int *data, const int n) {
+    constexpr int NUM_BATCHES = 5;
+    const int sortsPerBatch = std::max(1, (1 << 22) / std::max(n, 1));
+    std::vector<int> keys(n);
+
+    double best = std::numeric_limits<double>::max();
+    for (int batch = 0; batch < NUM_BATCHES; ++batch) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < sortsPerBatch; ++i) {
+            std::copy_n(data, n, keys.data());
+            sorter(keys.data(), n);
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count() / sortsPerBatch);
+    }
+    return best;
+}
@@ -1,17 +1,61 @@
 #include "parallel_radix_sort.h"
+#include "radix_sort.h"
+#include "radix_sorter.h"
 #include "data_generator.h"
 
 #include <iostream>
+#include <cstdio>
 #include <cstring>
 #include <algorithm>
+#include <compare>
+#include <limits>
+#include <numeric>
+#include <cstdint>
+#include <vector>
 
 constexpr int INPUT_SIZE = 8'000'000;
 constexpr auto DISTRIBUTION = DistributionType::NORMAL;
 constexpr int NUM_THREADS = 8;
+// fewer threads than NUM_THREADS and not a divisor of it
+constexpr int LIMITED_THREADS = 3;
+constexpr int SIGNED_OFFSET = 500'000;
+constexpr int64_t WIDE_KEY_SCALE = 1'000'000'007;
+constexpr double FLOAT_KEY_SCALE = 0.001;
+constexpr int CONSTANT_DIGIT_SHIFT = 8;
+constexpr int CONSTANT_DIGIT = 0x5a;
+constexpr int HIGH_KEY_BASE = 1'000'000'000;
+// segment sizes cycled through for segmented_sort, from empty to large enough for the parallel path
+constexpr int SEGMENT_SIZES[] = {0, 1, 7, 40, 1'000, 5'000, 300'000};
+// ranks checked by radix_select, as fractions of the input: min, median, p99, max
+constexpr double SELECT_QUANTILES[] = {0.0, 0.5, 0.99, 1.0};
+constexpr int TOP_K = 1'000;
+// the signed data cut into this many sorted runs, too many to merge, must still be radix sorted
+constexpr int MANY_RUNS = 64;
+// every this many keys of the low-cardinality data made unique, too few to notice in the sample but too many for
+// the counting tables, so that the counting sort must give up and radix sort instead
+constexpr int UNIQUE_KEY_STRIDE = 97;
+// Knuth's multiplicative hash, spreads the generated keys over all 32 bits
+constexpr uint32_t FULL_WIDTH_MULTIPLIER = 2'654'435'761u;
+constexpr const char *PROFILE_PATH = "validate_sort_profile.txt";
+// (shift, mask, offset) digits counted by the histogram kernels, the last with a key-range offset and a narrow digit
+constexpr uint32_t KERNEL_DIGITS[][3] = {{0, 0xff, 0}, {8, 0xff, 0}, {24, 0xff, 0}, {21, 0x7ff, 0}, {3, 0x3f, 12'345}};
+constexpr int KERNEL_INPUT_SIZE = 100'003;
+constexpr int PREFETCH_DISTANCE = 64;
+constexpr int STREAMED_LINES = 1'001;
+// with NUM_THREADS threads a chunk of each holds enough keys for 8-, 9-, 10- and 11-bit digits
+constexpr int ADAPTIVE_SIZES[] = {3'000, 6'000, 12'000, 100'000};
+constexpr std::size_t HUGE_PAGE_ARRAY_SIZES[] = {0, 1'000, HUGE_PAGE_SIZE / sizeof(int), 1'000'003};
+// around radix_sort's default crossovers, so that each of its algorithms gets a few inputs
+constexpr int SMALL_SIZES[] = {0, 1, 2, 3, 31, 32, 33, 100, 1'000, 65'535, 65'536, 100'000, 300'000};
 
-bool isValid(const int *arr, const int *expected, const int n) {
+// IEEE totalOrder, the order the floating-point radix sorts produce
+constexpr auto TOTAL_ORDER_LESS = [](const auto a, const auto b) { return std::strong_order(a, b) < 0; };
+
+template<typename Key>
+bool isValid(const Key *arr, const Key *expected, const int n) {
     for (int i = 0; i < n; ++i) {
-        if (arr[i] != expected[i]) {
+        // bitwise, so that NaNs and signed zeros of floating-point keys are compared exactly
+        if (std::memcmp(&arr[i], &expected[i], sizeof(Key)) != 0) {
             std::cout << "  Mismatch at index " << i << ": " << arr[i] << " != " << expected[i] << "\n";
             return false;
         }
@@ -21,6 +65,315 @@ bool isValid(const int *arr, const int *expected, const int n) {
     return true;
 }
 
+// sorts a scratch copy of input, which the sorters may clobber as their ping-pong buffer, so that input stays as
+// generated for the tests after this one
+template<typename Key>
+bool validateSortOn(const std::string &name, auto sortFunction, const Key *input, const Key *expected) {
+    auto *scratch = new Key[INPUT_SIZE];
+    auto *output = new Key[INPUT_SIZE];
+    std::memcpy(scratch, input, sizeof(Key) * INPUT_SIZE);
+    std::memcpy(output, input, sizeof(Key) * INPUT_SIZE);
+
+    std::cout << "Testing " << name << "...\n";
+    sortFunction(scratch, output, INPUT_SIZE, NUM_THREADS);
+    const bool valid = isValid(output, expected, INPUT_SIZE);
+
+    if (!valid) {
+        std::cout << "  " << name << " failed validation.\n";
+    }
+
+    delete[] scratch;
+    delete[] output;
+    return valid;
+}
+
+// values carry the original index of their key: keys must match, and equal keys must keep their input order
+template<typename Value>
+bool isValidPairs(const int *keys, const Value *values, const int *originalKeys, const int *expected, const int n) {
+    for (int i = 0; i < n; ++i) {
+        if (keys[i] != expected[i] || originalKeys[values[i]] != keys[i]) {
+            std::cout << "  Mismatch at index " << i << ": " << keys[i] << " (value " << values[i] << ") != "
+                    << expected[i] << "\n";
+            return false;
+        }
+        if (i > 0 && keys[i] == keys[i - 1] && values[i] <= values[i - 1]) {
+            std::cout << "  Unstable order at index " << i << ": " << values[i - 1] << " before " << values[i] << "\n";
+            return false;
+        }
+    }
+
+    std::cout << "  Sorted pairs are valid.\n";
+    return true;
+}
+
+// equal keys must be moved past each other for a sort to show whether it is stable, which sorted keys never need
+bool exercisesStability(const std::string &name, const int *keys) {
+    if (std::is_sorted(keys, keys + INPUT_SIZE)) {
+        std::cout << "  " << name << " input is already sorted, its stability would go unchecked.\n";
+        return false;
+    }
+    return true;
+}
+
+template<typename Value>
+bool validateSortPairs(const std::string &name, auto sortFunction, const int *originalKeys, const int *expected) {
+    if (!exercisesStability(name, originalKeys)) {
+        return false;
+    }
+
+    auto *keys = new int[INPUT_SIZE];
+    auto *values = new Value[INPUT_SIZE];
+    std::memcpy(keys, originalKeys, sizeof(int) * INPUT_SIZE);
+    std::iota(values, values + INPUT_SIZE, Value{0});
+
+    std::cout << "Testing " << name << "...\n";
+    sortFunction(keys, values, INPUT_SIZE, NUM_THREADS);
+    const bool valid = isValidPairs(keys, values, originalKeys, expected, INPUT_SIZE);
+
+    if (!valid) {
+        std::cout << "  " << name << " failed validation.\n";
+    }
+
+    delete[] keys;
+    delete[] values;
+    return valid;
+}
+
+bool validateArgsort(const std::string &name, auto argsortFunction, const int *keys, const int *expected) {
+    if (!exercisesStability(name, keys)) {
+        return false;
+    }
+
+    auto *indices = new uint32_t[INPUT_SIZE];
+    auto *permuted = new int[INPUT_SIZE];
+
+    std::cout << "Testing " << name << "...\n";
+    argsortFunction(keys, indices, INPUT_SIZE, NUM_THREADS);
+    for (int i = 0; i < INPUT_SIZE; ++i) {
+        permuted[i] = keys[indices[i]];
+    }
+    const bool valid = isValidPairs(permuted, indices, keys, expected, INPUT_SIZE);
+
+    if (!valid) {
+        std::cout << "  " << name << " failed validation.\n";
+    }
+
+    delete[] indices;
+    delete[] permuted;
+    return valid;
+}
+
+// sorts prefixes of input of each of SMALL_SIZES in place
+bool validateSmallSizes(const std::string &name, auto sortFunction, const int *input) {
+    std::cout << "Testing " << name << " on small inputs...\n";
+    for (const int n: SMALL_SIZES) {
+        std::vector<int> keys(input, input + n);
+        std::vector<int> expected(keys);
+        std::sort(expected.begin(), expected.end());
+
+        sortFunction(keys.data(), n, NUM_THREADS);
+        if (keys != expected) {
+            std::cout << "  " << name << " failed validation on " << n << " keys.\n";
+            return false;
+        }
+    }
+
+    std::cout << "  Sorted arrays are valid.\n";
+    return true;
+}
+
+// the digit widths of the last radix sort, lowest first (e.g. "10+10")
+std::string describeWidths(const RadixSortStats &stats) {
+    std::string widths;
+    for (int pass = 0; pass < stats.numPlannedPasses; ++pass) {
+        widths += (pass > 0 ? "+" : "") + std::to_string(stats.passWidths[pass]);
+    }
+    return widths;
+}
+
+// ParallelAllOptsAdaptive on prefixes of input short enough that NUM_THREADS chunks of them cap the digit at each of
+// the widths it has a sorter for
+bool validateAdaptiveWidths(const int *input) {
+    std::cout << "Testing ParallelAllOptsAdaptive::sort across digit widths...\n";
+    for (const int n: ADAPTIVE_SIZES) {
+        std::vector<int> keys(input, input + n);
+        std::vector<int> sorted(n);
+        std::vector<int> expected(keys);
+        std::sort(expected.begin(), expected.end());
+
+        ParallelAllOptsAdaptive::sort(keys.data(), sorted.data(), n, NUM_THREADS);
+        if (sorted != expected) {
+            std::cout << "  ParallelAllOptsAdaptive::sort failed validation on " << n << " keys ("
+                    << describeWidths(lastRadixSortStats) << ").\n";
+            return false;
+        }
+        std::cout << "  " << n << " keys sorted in " << describeWidths(lastRadixSortStats) << " bit passes.\n";
+    }
+    return true;
+}
+
+// the dispatched digit counting kernel and the scalar one must both count what a plain loop counts, summed over their
+// interleaved copies
+bool validateDigitCountKernels(const int *input) {
+    std::cout << "Testing digit counting kernels...\n";
+    const auto *bits = reinterpret_cast<const uint32_t *>(input);
+    constexpr uint32_t SIGN_FLIP = RadixKeyTraits<int>::SIGN_FLIP;
+    constexpr int STRIDE = 2048;
+
+    for (const auto &[shift, mask, offset]: KERNEL_DIGITS) {
+        std::vector<int> expected(STRIDE);
+        for (int i = 0; i < KERNEL_INPUT_SIZE; ++i) {
+            ++expected[((bits[i] ^ SIGN_FLIP) - offset) >> shift & mask];
+        }
+
+        for (const DigitCountKernel kernel: {digitCountKernel(), &countDigitsScalar}) {
+            std::vector<int> counts(DIGIT_COUNT_COPIES * STRIDE);
+            kernel(bits, KERNEL_INPUT_SIZE, counts.data(), STRIDE, SIGN_FLIP, offset, static_cast<int>(shift), mask);
+            for (int copy = 1; copy < DIGIT_COUNT_COPIES; ++copy) {
+                for (int digit = 0; digit < STRIDE; ++digit) {
+                    counts[digit] += counts[copy * STRIDE + digit];
+                }
+            }
+            if (!std::equal(expected.begin(), expected.end(), counts.begin())) {
+                std::cout << "  Digit counts differ for shift " << shift << ", mask " << mask << ".\n";
+                return false;
+            }
+        }
+    }
+
+    std::cout << "  Digit counts are valid.\n";
+    return true;
+}
+
+// arrays under a huge page come from the heap, larger ones are mapped on a huge page boundary; every element must be
+// writable and read back after the prefault
+bool validateHugePageArrays() {
+    std::cout << "Testing huge page arrays...\n";
+    for (const std::size_t size: HUGE_PAGE_ARRAY_SIZES) {
+        const auto array = makeHugePageArray<int>(size, NUM_THREADS);
+        const PageBacking backing = array.get_deleter().backing;
+        const bool mapped = size * sizeof(int) >= HUGE_PAGE_SIZE;
+        if (mapped == (backing == PageBacking::HEAP) ||
+            (mapped && reinterpret_cast<std::uintptr_t>(array.get()) % HUGE_PAGE_SIZE != 0)) {
+            std::cout << "  Array of " << size << " ints is on " << pageBackingToString(backing) << ".\n";
+            return false;
+        }
+
+        std::iota(array.get(), array.get() + size, 0);
+        for (std::size_t i = 0; i < size; ++i) {
+            if (array[i] != static_cast<int>(i)) {
+                std::cout << "  Array of " << size << " ints lost element " << i << ".\n";
+                return false;
+            }
+        }
+        std::cout << "  " << size << " ints on " << pageBackingToString(backing) << ".\n";
+    }
+    return true;
+}
+
+// the dispatched non-temporal line copy and the SSE2 one must both copy every line exactly, from an unaligned source
+bool validateStreamLinesKernels(const int *input) {
+#if defined(__SSE2__)
+    std::cout << "Testing streaming store kernels...\n";
+    constexpr int KEYS_PER_LINE = CACHE_LINE_SIZE / sizeof(int);
+    const auto lines = makeAlignedArray<int>(STREAMED_LINES * KEYS_PER_LINE);
+    for (const StreamLinesKernel kernel: {streamLinesKernel(), &streamLinesSse2}) {
+        std::fill_n(lines.get(), STREAMED_LINES * KEYS_PER_LINE, 0);
+        kernel(lines.get(), input + 1, STREAMED_LINES);
+        _mm_sfence();
+        if (!std::equal(lines.get(), lines.get() + STREAMED_LINES * KEYS_PER_LINE, input + 1)) {
+            std::cout << "  Streamed lines differ from their source.\n";
+            return false;
+        }
+    }
+    std::cout << "  Streamed lines are valid.\n";
+#endif
+    return true;
+}
+
+// sorts consecutive segments of a copy of input cycling through SEGMENT_SIZES, each must match its std::sort
+bool validateSegmentedSort(const std::string &name, auto sortFunction, const int *input) {
+    std::vector<int> offsets = {0};
+    for (int segment = 0; offsets.back() < INPUT_SIZE; ++segment) {
+        const int size = SEGMENT_SIZES[segment % std::size(SEGMENT_SIZES)];
+        offsets.push_back(std::min(offsets.back() + size, INPUT_SIZE));
+    }
+    const int numSegments = static_cast<int>(offsets.size()) - 1;
+
+    std::vector<int> keys(input, input + INPUT_SIZE);
+    std::vector<int> expected(keys);
+    for (int segment = 0; segment < numSegments; ++segment) {
+        std::sort(expected.begin() + offsets[segment], expected.begin() + offsets[segment + 1]);
+    }
+
+    std::cout << "Testing " << name << " on " << numSegments << " segments...\n";
+    sortFunction(keys.data(), offsets.data(), numSegments, NUM_THREADS);
+    const bool valid = isValid(keys.data(), expected.data(), INPUT_SIZE);
+
+    if (!valid) {
+        std::cout << "  " << name << " failed validation.\n";
+    }
+    return valid;
+}
+
+// radix_select at SELECT_QUANTILES, and the TOP_K smallest (sorted) and largest keys, against the sorted input
+bool validateSelection(const int *input, const int *expected) {
+    std::cout << "Testing radix_select, radix_partial_sort and radix_topk...\n";
+    for (const double quantile: SELECT_QUANTILES) {
+        const int k = std::min(static_cast<int>(quantile * INPUT_SIZE), INPUT_SIZE - 1);
+        const int selected = radix_select(input, INPUT_SIZE, k, NUM_THREADS);
+        if (selected != expected[k]) {
+            std::cout << "  radix_select of rank " << k << ": " << selected << " != " << expected[k] << "\n";
+            return false;
+        }
+    }
+
+    std::vector<int> smallest(TOP_K);
+    radix_partial_sort(input, INPUT_SIZE, TOP_K, smallest.data(), NUM_THREADS);
+    if (!std::equal(smallest.begin(), smallest.end(), expected)) {
+        std::cout << "  radix_partial_sort failed validation.\n";
+        return false;
+    }
+
+    std::vector<int> largest(TOP_K);
+    radix_topk(input, INPUT_SIZE, TOP_K, largest.data(), NUM_THREADS);
+    std::sort(largest.begin(), largest.end());
+    if (!std::equal(largest.begin(), largest.end(), expected + INPUT_SIZE - TOP_K)) {
+        std::cout << "  radix_topk failed validation.\n";
+        return false;
+    }
+
+    std::cout << "  Selections are valid.\n";
+    return true;
+}
+
+// ParallelAllOpts on an input in a known order: the sort must be valid and must have recognized that order
+bool validatePresorted(const std::string &name, const int *input, const int *expected,
+                       const InputOrder expectedOrder) {
+    const bool valid = validateSortOn("ParallelAllOpts::sort (" + name + ")", ParallelAllOpts::sort, input, expected);
+    if (lastRadixSortStats.inputOrder != expectedOrder) {
+        std::cout << "  " << name << " input was not recognized.\n";
+        return false;
+    }
+    return valid;
+}
+
+// ParallelAllOpts on an input of few or many distinct keys: the sort must be valid and must have counting sorted
+// exactly the inputs of few distinct keys
+bool validateLowCardinality(const std::string &name, const int *input, const bool expectCounted) {
+    const auto expected = new int[INPUT_SIZE];
+    std::memcpy(expected, input, sizeof(int) * INPUT_SIZE);
+    std::sort(expected, expected + INPUT_SIZE);
+
+    const bool valid = validateSortOn("ParallelAllOpts::sort (" + name + ")", ParallelAllOpts::sort, input, expected);
+    delete[] expected;
+    if ((lastRadixSortStats.numDistinct > 0) != expectCounted) {
+        std::cout << "  " << name << " input was " << (expectCounted ? "not " : "") << "counting sorted.\n";
+        return false;
+    }
+    return valid;
+}
+
 int main() {
     std::cout << "Validating ParallelRadixSort implementations...\n";
     std::cout << "- Thread count: " << NUM_THREADS << "\n";
@@ -34,29 +387,314 @@ int main() {
     std::sort(expectedData, expectedData + INPUT_SIZE);
 
     auto validateSort = [&](const std::string &name, auto sortFunction) -> bool {
-        auto *output = new int[INPUT_SIZE];
-        std::memcpy(output, originalData, sizeof(int) * INPUT_SIZE);
-
-        std::cout << "Testing " << name << "...\n";
-        sortFunction(originalData, output, INPUT_SIZE, NUM_THREADS);
-        const bool valid = isValid(output, expectedData, INPUT_SIZE);
-
-        if (!valid) {
-            std::cout << "  " << name << " failed validation.\n";
-        }
+        return validateSortOn(name, sortFunction, originalData, expectedData);
+    };
 
-        delete[] output;
-        return valid;
+    // the in-place sorter has no output array, it sorts the copy of the input that validateSortOn hands it
+    const auto sortInPlace = [](int *, int *output, const int n, const int numThreads) {
+        ParallelInPlace::sort(output, n, numThreads);
     };
 
     bool allValid = true;
 
+    allValid &= validateDigitCountKernels(originalData);
+    allValid &= validateStreamLinesKernels(originalData);
+    allValid &= validateHugePageArrays();
     allValid &= validateSort("BaseParallel::sort", BaseParallel::sort);
     allValid &= validateSort("ParallelOptA::sort", ParallelOptA::sort);
     allValid &= validateSort("ParallelOptB::sort", ParallelOptB::sort);
     allValid &= validateSort("ParallelOptC::sort", ParallelOptC::sort);
     allValid &= validateSort("ParallelOptAC::sort", ParallelOptAC::sort);
     allValid &= validateSort("ParallelAllOpts::sort", ParallelAllOpts::sort);
+    allValid &= validateSort("ParallelAllOptsFused::sort", ParallelAllOptsFused::sort);
+    allValid &= validateSort("ParallelAllOptsNextPass::sort", ParallelAllOptsNextPass::sort);
+    allValid &= validateSort("ParallelAllOptsStreaming::sort", ParallelAllOptsStreaming::sort);
+    allValid &= validateSort("ParallelAllOptsAdaptive::sort", ParallelAllOptsAdaptive::sort);
+    allValid &= validateAdaptiveWidths(originalData);
+    allValid &= validateSort("ParallelHybrid::sort", ParallelHybrid::sort);
+    allValid &= validateSort("ParallelInPlace::sort", sortInPlace);
+
+    // a host teams region whose thread_limit caps the sorts' parallel regions below NUM_THREADS, as OMP_THREAD_LIMIT
+    // would: the scratch they share between threads must be laid out for the team they got
+    const auto underThreadLimit = [](const auto sortFunction) {
+        return [sortFunction](int *input, int *output, const int n, const int numThreads) {
+            #pragma omp teams num_teams(1) thread_limit(LIMITED_THREADS)
+            sortFunction(input, output, n, numThreads);
+        };
+    };
+    allValid &= validateSort("ParallelAllOptsFused::sort (thread limit)", underThreadLimit(ParallelAllOptsFused::sort));
+    allValid &= validateSort("ParallelAllOptsNextPass::sort (thread limit)",
+                             underThreadLimit(ParallelAllOptsNextPass::sort));
+
+    using RadixFeatures::MaxBitsEarlyExit;
+    allValid &= validateSort("RadixSorter<int, 6>::sort", RadixSorter<int, 6, 128, MaxBitsEarlyExit>::sort);
+    allValid &= validateSort("RadixSorter<int, 11>::sort", RadixSorter<int, 11, 64, MaxBitsEarlyExit>::sort);
+    allValid &= validateSort("RadixSorter<int, 16>::sort", RadixSorter<int, 16, 16, MaxBitsEarlyExit>::sort);
+
+    // shift the data so that about half of the keys are negative
+    std::cout << "\nSigned input (keys shifted by -" << SIGNED_OFFSET << ")...\n";
+    for (int i = 0; i < INPUT_SIZE; ++i) {
+        originalData[i] -= SIGNED_OFFSET;
+        expectedData[i] -= SIGNED_OFFSET;
+    }
+
+    allValid &= validateSort("ParallelOptB::sort", ParallelOptB::sort);
+    allValid &= validateSort("ParallelOptAC::sort", ParallelOptAC::sort);
+    allValid &= validateSort("ParallelAllOpts::sort", ParallelAllOpts::sort);
+    allValid &= validateSort("ParallelAllOptsFused::sort", ParallelAllOptsFused::sort);
+    allValid &= validateSort("ParallelAllOptsNextPass::sort", ParallelAllOptsNextPass::sort);
+    allValid &= validateSort("ParallelAllOptsStreaming::sort", ParallelAllOptsStreaming::sort);
+    allValid &= validateSort("ParallelAllOptsAdaptive::sort", ParallelAllOptsAdaptive::sort);
+    allValid &= validateSort("ParallelHybrid::sort", ParallelHybrid::sort);
+    allValid &= validateSort("ParallelInPlace::sort", sortInPlace);
+
+    // one context for several sorts, the first of which outgrows its initial capacity
+    ParallelAllOpts::Context context(INPUT_SIZE / 4, NUM_THREADS);
+    const auto sortWithContext = [&context](int *, int *output, const int n, int) {
+        ParallelAllOpts::sortWithContext(context, output, n);
+    };
+    allValid &= validateSort("ParallelAllOpts::sortWithContext", sortWithContext);
+    allValid &= validateSort("ParallelAllOpts::sortWithContext (reused)", sortWithContext);
+    const auto sortOnFewerThreads = [&context](int *, int *output, const int n, int) {
+        context.sort(output, n, NUM_THREADS / 2);
+    };
+    allValid &= validateSort("ParallelAllOpts::Context (fewer threads)", sortOnFewerThreads);
+
+    // the context from inside a parallel region, where OpenMP grants it a team of one: a two-run input must be
+    // classified from that team's order counts alone, not with the rows a full-team sort of another two-run input
+    // left in the workspace. The keys span all 32 bits, so that a stale third run still looks worth merging.
+    const auto twoRunData = new int[INPUT_SIZE];
+    const auto expectedTwoRuns = new int[INPUT_SIZE];
+    for (int i = 0; i < INPUT_SIZE; ++i) {
+        expectedTwoRuns[i] = static_cast<int>(static_cast<uint32_t>(originalData[i]) * FULL_WIDTH_MULTIPLIER);
+    }
+    std::sort(expectedTwoRuns, expectedTwoRuns + INPUT_SIZE);
+
+    const auto makeTwoRuns = [&](const int split) {
+        for (int i = 0; i < INPUT_SIZE; ++i) {
+            twoRunData[i] = static_cast<int>(static_cast<uint32_t>(originalData[i]) * FULL_WIDTH_MULTIPLIER);
+        }
+        std::sort(twoRunData, twoRunData + split);
+        std::sort(twoRunData + split, twoRunData + INPUT_SIZE);
+    };
+    const auto sortNested = [&context](int *, int *output, const int n, int) {
+        #pragma omp parallel num_threads(2) default(none) shared(context, output, n)
+        #pragma omp single
+        ParallelAllOpts::sortWithContext(context, output, n);
+    };
+    makeTwoRuns(INPUT_SIZE / 2);
+    allValid &= validateSortOn("ParallelAllOpts::sortWithContext (two runs)", sortWithContext, twoRunData,
+                               expectedTwoRuns);
+    makeTwoRuns(2 * (INPUT_SIZE / 3));
+    allValid &= validateSortOn("ParallelAllOpts::sortWithContext (two runs, in a parallel region)", sortNested,
+                               twoRunData, expectedTwoRuns);
+    delete[] twoRunData;
+    delete[] expectedTwoRuns;
+
+    // the prefetching scatters, staged and unstaged
+    context.setPrefetchDistance(PREFETCH_DISTANCE);
+    allValid &= validateSort("ParallelAllOpts::sortWithContext (prefetch)", sortWithContext);
+    using UnstagedSorter = RadixSorter<int, 11, 0, RadixFeatures::KeyRangeEarlyExit>;
+    RadixSortContext<UnstagedSorter> unstagedContext(INPUT_SIZE, NUM_THREADS);
+    unstagedContext.setPrefetchDistance(PREFETCH_DISTANCE);
+    allValid &= validateSort("RadixSorter<int, 11, 0> context (prefetch)", [&](int *, int *output, const int n, int) {
+        unstagedContext.sort(output, n);
+    });
+
+    const auto sortDispatched = [](int *, int *output, const int n, const int numThreads) {
+        radix_sort(output, n, numThreads);
+    };
+    allValid &= validateSort("radix_sort", sortDispatched);
+    allValid &= validateSmallSizes("radix_sort", radix_sort, originalData);
+
+    allValid &= validateSegmentedSort("segmented_sort", segmented_sort, originalData);
+    allValid &= validateSelection(originalData, expectedData);
+
+    // a profile that sends each size band to a different configuration, through a save/load round trip
+    std::cout << "Testing radix_sort tuning profile round trip...\n";
+    const RadixSortProfile profile = {
+        {32, {RadixSortAlgorithm::INSERTION_SORT, 1}},
+        {1'000, {RadixSortAlgorithm::SERIAL_RADIX_SORT, 1}},
+        {100'000, {RadixSortAlgorithm::PARALLEL_RADIX_SORT, NUM_THREADS, 11, 64}},
+        {std::numeric_limits<int>::max(), {RadixSortAlgorithm::PARALLEL_RADIX_SORT, NUM_THREADS / 2, 8, 128}},
+    };
+    const bool profileLoaded = saveRadixSortProfile(PROFILE_PATH, profile) && loadRadixSortProfile(PROFILE_PATH)
+                               && radixSortProfile().size() == profile.size();
+    std::remove(PROFILE_PATH);
+    std::cout << (profileLoaded ? "  Profile loaded.\n" : "  radix_sort profile failed to load.\n");
+    allValid &= profileLoaded;
+    allValid &= validateSort("radix_sort (profile)", sortDispatched);
+    allValid &= validateSmallSizes("radix_sort (profile)", radix_sort, originalData);
+    allValid &= validateSegmentedSort("segmented_sort (profile)", segmented_sort, originalData);
+    setRadixSortProfile({});
+
+    const auto sortPairs = [](int *keys, auto *values, const int n, const int numThreads) {
+        ParallelAllOpts::sortPairs(keys, values, n, numThreads);
+    };
+    allValid &= validateSortPairs<uint32_t>("ParallelAllOpts::sortPairs (uint32_t)", sortPairs, originalData,
+                                            expectedData);
+    allValid &= validateSortPairs<uint64_t>("ParallelAllOpts::sortPairs (uint64_t)", sortPairs, originalData,
+                                            expectedData);
+    allValid &= validateSortPairs<uint32_t>("ParallelAllOpts::sortPairsPacked", ParallelAllOpts::sortPairsPacked,
+                                            originalData, expectedData);
+    allValid &= validateArgsort("ParallelAllOpts::argsort", ParallelAllOpts::argsort, originalData, expectedData);
+
+    // the sorted signed data, reversed, and cut into sorted runs
+    std::cout << "\nPresorted input...\n";
+    const auto presortedData = new int[INPUT_SIZE];
+    std::memcpy(presortedData, expectedData, sizeof(int) * INPUT_SIZE);
+    allValid &= validatePresorted("sorted", presortedData, expectedData, InputOrder::SORTED);
+
+    std::reverse_copy(expectedData, expectedData + INPUT_SIZE, presortedData);
+    allValid &= validatePresorted("reversed", presortedData, expectedData, InputOrder::REVERSED);
+
+    for (const int numRuns: {SORTED_RUNS_COUNT, MANY_RUNS}) {
+        std::memcpy(presortedData, originalData, sizeof(int) * INPUT_SIZE);
+        for (int run = 0; run < numRuns; ++run) {
+            std::sort(presortedData + static_cast<long long>(INPUT_SIZE) * run / numRuns,
+                      presortedData + static_cast<long long>(INPUT_SIZE) * (run + 1) / numRuns);
+        }
+        allValid &= validatePresorted(std::to_string(numRuns) + " runs", presortedData, expectedData,
+                                      numRuns == SORTED_RUNS_COUNT ? InputOrder::FEW_RUNS : InputOrder::UNSORTED);
+    }
+    delete[] presortedData;
+
+    std::cout << "\nLow-cardinality input...\n";
+    const auto lowCardinalityData = DataGenerator::generate(INPUT_SIZE, DistributionType::LOW_CARDINALITY);
+    allValid &= validateLowCardinality("low cardinality", lowCardinalityData, true);
+    for (int i = 1; i < INPUT_SIZE; i += UNIQUE_KEY_STRIDE) {
+        lowCardinalityData[i] = -i;
+    }
+    allValid &= validateLowCardinality("low cardinality, scattered unique keys", lowCardinalityData, false);
+    delete[] lowCardinalityData;
+
+    // shift a constant byte in below the signed data, so that the lowest digit is the same for every key and the
+    // sorters with SkipTrivialPasses leave out its scatter
+    std::cout << "\nConstant low digit (keys shifted left by " << CONSTANT_DIGIT_SHIFT << ")...\n";
+    const auto originalDataConstantDigit = new int[INPUT_SIZE];
+    const auto expectedDataConstantDigit = new int[INPUT_SIZE];
+    for (int i = 0; i < INPUT_SIZE; ++i) {
+        originalDataConstantDigit[i] = originalData[i] * (1 << CONSTANT_DIGIT_SHIFT) + CONSTANT_DIGIT;
+        expectedDataConstantDigit[i] = expectedData[i] * (1 << CONSTANT_DIGIT_SHIFT) + CONSTANT_DIGIT;
+    }
+
+    const auto validateSortConstantDigit = [&](const std::string &name, auto sortFunction) -> bool {
+        return validateSortOn(name, sortFunction, originalDataConstantDigit, expectedDataConstantDigit);
+    };
+    allValid &= validateSortConstantDigit("ParallelAllOpts::sort", ParallelAllOpts::sort);
+    allValid &= validateSortConstantDigit("ParallelAllOptsFused::sort", ParallelAllOptsFused::sort);
+    allValid &= validateSortConstantDigit("ParallelAllOptsNextPass::sort", ParallelAllOptsNextPass::sort);
+    allValid &= validateSortPairs<uint32_t>("ParallelAllOpts::sortPairs (uint32_t)", sortPairs,
+                                            originalDataConstantDigit, expectedDataConstantDigit);
+    allValid &= validateSortPairs<uint32_t>("ParallelAllOpts::sortPairsPacked", ParallelAllOpts::sortPairsPacked,
+                                            originalDataConstantDigit, expectedDataConstantDigit);
+    allValid &= validateArgsort("ParallelAllOpts::argsort", ParallelAllOpts::argsort, originalDataConstantDigit,
+                                expectedDataConstantDigit);
+
+    delete[] originalDataConstantDigit;
+    delete[] expectedDataConstantDigit;
+
+    // lift the signed data far above zero, so that ParallelAllOpts sorts on the ~20-bit key range (max - min)
+    // instead of the full width of the keys
+    std::cout << "\nHigh-offset input (keys shifted by +" << HIGH_KEY_BASE << ")...\n";
+    const auto originalDataHigh = new int[INPUT_SIZE];
+    const auto expectedDataHigh = new int[INPUT_SIZE];
+    for (int i = 0; i < INPUT_SIZE; ++i) {
+        originalDataHigh[i] = originalData[i] + HIGH_KEY_BASE;
+        expectedDataHigh[i] = expectedData[i] + HIGH_KEY_BASE;
+    }
+
+    allValid &= validateSortOn("ParallelAllOpts::sort", ParallelAllOpts::sort, originalDataHigh, expectedDataHigh);
+    allValid &= validateSortOn("ParallelAllOptsFused::sort", ParallelAllOptsFused::sort, originalDataHigh,
+                               expectedDataHigh);
+    allValid &= validateSortOn("ParallelAllOptsNextPass::sort", ParallelAllOptsNextPass::sort, originalDataHigh,
+                               expectedDataHigh);
+    allValid &= validateSortOn("ParallelAllOptsStreaming::sort", ParallelAllOptsStreaming::sort, originalDataHigh,
+                               expectedDataHigh);
+    allValid &= validateSortOn("ParallelAllOptsAdaptive::sort", ParallelAllOptsAdaptive::sort, originalDataHigh,
+                               expectedDataHigh);
+    allValid &= validateSortOn("ParallelHybrid::sort", ParallelHybrid::sort, originalDataHigh, expectedDataHigh);
+    allValid &= validateSortOn("ParallelInPlace::sort", sortInPlace, originalDataHigh, expectedDataHigh);
+    allValid &= validateSelection(originalDataHigh, expectedDataHigh);
+    allValid &= validateSortPairs<uint32_t>("ParallelAllOpts::sortPairs (uint32_t)", sortPairs, originalDataHigh,
+                                            expectedDataHigh);
+    allValid &= validateArgsort("ParallelAllOpts::argsort", ParallelAllOpts::argsort, originalDataHigh,
+                                expectedDataHigh);
+
+    delete[] originalDataHigh;
+    delete[] expectedDataHigh;
+
+    // widen the signed data to 64-bit keys that span ~50 bits, and offset a copy into unsigned range
+    std::cout << "\n64-bit input (keys scaled by " << WIDE_KEY_SCALE << ")...\n";
+    const auto originalData64 = new int64_t[INPUT_SIZE];
+    const auto expectedData64 = new int64_t[INPUT_SIZE];
+    const auto originalDataU64 = new uint64_t[INPUT_SIZE];
+    const auto expectedDataU64 = new uint64_t[INPUT_SIZE];
+    for (int i = 0; i < INPUT_SIZE; ++i) {
+        originalData64[i] = originalData[i] * WIDE_KEY_SCALE;
+        expectedData64[i] = expectedData[i] * WIDE_KEY_SCALE;
+        originalDataU64[i] = static_cast<uint64_t>(originalData64[i]) ^ (1ULL << 63);
+        expectedDataU64[i] = static_cast<uint64_t>(expectedData64[i]) ^ (1ULL << 63);
+    }
+
+    const auto sort64Digit11 = [](auto *input, auto *output, const int n, const int numThreads) {
+        ParallelAllOpts64Digit11::sort(input, output, n, numThreads);
+    };
+    const auto sort64Digit16 = [](auto *input, auto *output, const int n, const int numThreads) {
+        ParallelAllOpts64Digit16::sort(input, output, n, numThreads);
+    };
+
+    allValid &= validateSortOn("ParallelAllOpts64Digit11::sort (int64_t)", sort64Digit11, originalData64,
+                               expectedData64);
+    allValid &= validateSortOn("ParallelAllOpts64Digit16::sort (int64_t)", sort64Digit16, originalData64,
+                               expectedData64);
+    allValid &= validateSortOn("ParallelAllOpts64Digit11::sort (uint64_t)", sort64Digit11, originalDataU64,
+                               expectedDataU64);
+    allValid &= validateSortOn("ParallelAllOpts64Digit16::sort (uint64_t)", sort64Digit16, originalDataU64,
+                               expectedDataU64);
+
+    delete[] originalData64;
+    delete[] expectedData64;
+    delete[] originalDataU64;
+    delete[] expectedDataU64;
+
+    // scale the signed data into fractional floating-point keys and mix in zeros, infinities and NaNs of both signs
+    std::cout << "\nFloating-point input (keys scaled by " << FLOAT_KEY_SCALE << ", with special values)...\n";
+    const auto originalFloats = new float[INPUT_SIZE];
+    const auto originalDoubles = new double[INPUT_SIZE];
+    for (int i = 0; i < INPUT_SIZE; ++i) {
+        originalFloats[i] = static_cast<float>(originalData[i] * FLOAT_KEY_SCALE);
+        originalDoubles[i] = originalData[i] * FLOAT_KEY_SCALE;
+    }
+
+    constexpr double SPECIAL_VALUES[] = {
+        0.0, -0.0, std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+        std::numeric_limits<double>::quiet_NaN(), -std::numeric_limits<double>::quiet_NaN(),
+        std::numeric_limits<double>::denorm_min(), -std::numeric_limits<double>::denorm_min()
+    };
+    for (int i = 0; i < INPUT_SIZE; i += INPUT_SIZE / 1000) {
+        const double special = SPECIAL_VALUES[i % std::size(SPECIAL_VALUES)];
+        originalFloats[i] = static_cast<float>(special);
+        originalDoubles[i] = special;
+    }
+
+    const auto expectedFloats = new float[INPUT_SIZE];
+    const auto expectedDoubles = new double[INPUT_SIZE];
+    std::memcpy(expectedFloats, originalFloats, sizeof(float) * INPUT_SIZE);
+    std::memcpy(expectedDoubles, originalDoubles, sizeof(double) * INPUT_SIZE);
+    std::sort(expectedFloats, expectedFloats + INPUT_SIZE, TOTAL_ORDER_LESS);
+    std::sort(expectedDoubles, expectedDoubles + INPUT_SIZE, TOTAL_ORDER_LESS);
+
+    const auto sortFloat = [](auto *input, auto *output, const int n, const int numThreads) {
+        ParallelAllOptsFloat::sort(input, output, n, numThreads);
+    };
+    allValid &= validateSortOn("ParallelAllOptsFloat::sort (float)", sortFloat, originalFloats, expectedFloats);
+    allValid &= validateSortOn("ParallelAllOptsFloat::sort (double)", sortFloat, originalDoubles, expectedDoubles);
+
+    delete[] originalFloats;
+    delete[] originalDoubles;
+    delete[] expectedFloats;
+    delete[] expectedDoubles;
 
     delete[] originalData;
     delete[] expectedData;
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <omp.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// how one worker of the most recent work-stealing runs on the calling thread spent its time, for reporting
+struct WorkerLoad {
+    double busySeconds = 0.0;
+    double idleSeconds = 0.0;
+    int tasks = 0;
+    int steals = 0;
+};
+
+inline thread_local std::vector<WorkerLoad> lastWorkerLoads;
+
+// Chase-Lev deque of fixed capacity: the owning thread pushes and pops at the bottom (LIFO, so it keeps working on
+// the most recently split and cache-warm ranges), other threads steal from the top (the oldest, largest tasks)
+template<typename Task>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable_v<Task> && sizeof(Task) <= 8, "tasks are stored in lock-free atomics");
+
+public:
+    static constexpr int64_t CAPACITY = 1 << 12;
+
+    // owner only; false when the deque is full
+    bool push(const Task task) {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= CAPACITY) {
+            return false;
+        }
+
+        slots[b & (CAPACITY - 1)].store(task, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // owner only
+    std::optional<Task> pop() {
+        const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        const Task task = slots[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (t < b) {
+            return task;
+        }
+
+        // the last task: race the thieves for it
+        const bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return won ? std::optional(task) : std::nullopt;
+    }
+
+    // any thread
+    std::optional<Task> steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return std::nullopt;
+        }
+
+        const Task task = slots[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return std::nullopt;
+        }
+        return task;
+    }
+
+private:
+    // the owner's and the thieves' ends on separate cache lines
+    alignas(64) std::atomic<int64_t> top{0};
+    alignas(64) std::atomic<int64_t> bottom{0};
+    std::atomic<Task> slots[CAPACITY];
+};
+
+// spreads uneven task work over the threads of an OpenMP team: every thread owns a deque, runs its own tasks first
+// and steals from a random victim when it runs dry. Tasks may spawn more tasks; the run ends once every task spawned
+// has finished. Usage, inside a parallel region of numWorkers threads:
+//   pool.spawn(tid, task, process) for the initial tasks, a barrier, then pool.run(tid, process)
+// where process(task, tid) handles one task and may call spawn(tid, ...) itself.
+template<typename Task>
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(const int numWorkers)
+        : deques(std::make_unique<WorkStealingDeque<Task>[]>(numWorkers)),
+          loads(std::make_unique<WorkerLoad[]>(numWorkers)),
+          numWorkers(numWorkers) {}
+
+    // queues a task on the worker's deque, or runs it right away when the deque is full
+    template<typename Process>
+    void spawn(const int worker, const Task task, Process &&process) {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        if (!deques[worker].push(task)) {
+            pending.fetch_sub(1, std::memory_order_relaxed);
+            process(task, worker);
+        }
+    }
+
+    template<typename Process>
+    void run(const int worker, Process &&process) {
+        const double start = omp_get_wtime();
+        WorkerLoad &load = loads[worker];
+        std::minstd_rand rng(worker + 1);
+
+        while (true) {
+            std::optional<Task> task = deques[worker].pop();
+            if (!task && numWorkers > 1) {
+                const int victim = static_cast<int>((worker + 1 + rng() % (numWorkers - 1)) % numWorkers);
+                task = deques[victim].steal();
+                load.steals += task.has_value();
+            }
+
+            if (task) {
+                const double taskStart = omp_get_wtime();
+                process(*task, worker);
+                load.busySeconds += omp_get_wtime() - taskStart;
+                ++load.tasks;
+                pending.fetch_sub(1, std::memory_order_acq_rel);
+            } else if (pending.load(std::memory_order_acquire) == 0) {
+                break;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        load.idleSeconds = omp_get_wtime() - start - load.busySeconds;
+    }
+
+    // adds each worker's time in this pool onto totals (one entry per worker)
+    void addLoadsTo(std::vector<WorkerLoad> &totals) const {
+        totals.resize(std::max<size_t>(totals.size(), numWorkers));
+        for (int worker = 0; worker < numWorkers; ++worker) {
+            totals[worker].busySeconds += loads[worker].busySeconds;
+            totals[worker].idleSeconds += loads[worker].idleSeconds;
+            totals[worker].tasks += loads[worker].tasks;
+            totals[worker].steals += loads[worker].steals;
+        }
+    }
+
+private:
+    std::unique_ptr<WorkStealingDeque<Task>[]> deques;
+    std::unique_ptr<WorkerLoad[]> loads;
+    const int numWorkers;
+
+    // tasks spawned and not yet finished; a task spawns its children before it counts as finished
+    alignas(64) std::atomic<int64_t> pending{0};
+};